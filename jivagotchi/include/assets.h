@@ -0,0 +1,61 @@
+/*
+ * Jiva-gotchi: Generated Assets
+ * Generated by tools/gen_assets.py from art/, do not edit by hand
+ * 16 frames -> 4 bitmaps, 192 bytes raw, 146 bytes compressed
+*/
+
+#ifndef ASSETS_H
+#define ASSETS_H
+
+#include "sprite.h"
+
+static const uint8_t asset_levels = 4;
+
+// RLE streams, see tools/gen_assets.py for the format
+static const uint8_t asset_bitmap_data[] PROGMEM = {
+  0x8d, 0x00, 0x21, 0xf8, 0x1f, 0x08, 0x10, 0x08, 0x10, 0x08, 0x10, 0x08,
+  0x10, 0xe8, 0x38, 0xc8, 0x18, 0xc8, 0x18, 0x08, 0x10, 0x08, 0x10, 0x08,
+  0x10, 0xf8, 0x1f, 0x08, 0x10, 0x08, 0x10, 0xf8, 0x1f, 0x38, 0x0e, 0x18,
+  0x06, 0x8b, 0x00, 0x23, 0xf8, 0x1f, 0xf8, 0x1f, 0xf8, 0x1f, 0xf8, 0x1f,
+  0x38, 0x10, 0x18, 0x10, 0xf8, 0x38, 0xc8, 0x18, 0xc8, 0x18, 0x08, 0x10,
+  0x08, 0x10, 0x08, 0x10, 0xf8, 0x1f, 0x08, 0x10, 0x08, 0x10, 0xf8, 0x1f,
+  0x38, 0x0e, 0x18, 0x06, 0x8d, 0x00, 0x21, 0xe0, 0x07, 0xf0, 0x0f, 0xf8,
+  0x1f, 0xf8, 0x1f, 0x3c, 0x10, 0x1c, 0x10, 0xdc, 0x18, 0xdc, 0x78, 0x3c,
+  0x70, 0xfc, 0x7f, 0xf8, 0x3f, 0xc8, 0x3f, 0x88, 0x1f, 0x08, 0x17, 0xc8,
+  0x13, 0x28, 0x0a, 0x18, 0x06, 0x91, 0x00, 0x1d, 0xf0, 0x1f, 0x78, 0x10,
+  0x3c, 0x10, 0xfc, 0x38, 0xdc, 0x18, 0xdc, 0x18, 0x3c, 0x30, 0xfc, 0x7f,
+  0xf8, 0x3f, 0xf8, 0x3f, 0x88, 0x1f, 0x88, 0x1f, 0xf8, 0x1f, 0xb8, 0x0f,
+  0x98, 0x07,
+};
+
+static const uint16_t asset_bitmap_offset[] PROGMEM = { 0, 37, 76, 113 };
+
+// { bitmap, dy, patch_row, patch, ms }
+static const sprite_frame asset_idle_frames[4][idle_frames] PROGMEM = {
+  {
+    { 0, 0, no_patch, 0x0000, 34 }, // Level 1/idle_0.xbm
+    { 0, 1, no_patch, 0x0000, 34 }, // Level 1/idle_1.xbm
+    { 0, 2, no_patch, 0x0000, 34 }, // Level 1/idle_2.xbm
+    { 0, 1, no_patch, 0x0000, 40 }, // Level 1/idle_3.xbm
+  },
+  {
+    { 1, 0, no_patch, 0x0000, 34 }, // Level 2/idle_0.xbm
+    { 1, 1, no_patch, 0x0000, 34 }, // Level 2/idle_1.xbm
+    { 1, 2, no_patch, 0x0000, 34 }, // Level 2/idle_2.xbm
+    { 1, 1, no_patch, 0x0000, 40 }, // Level 2/idle_3.xbm
+  },
+  {
+    { 2, 0, no_patch, 0x0000, 34 }, // Level 3/idle_00.xbm
+    { 2, 1, 23, 0x0410, 34 }, // Level 3/idle_01.xbm
+    { 2, 2, 23, 0x0c30, 34 }, // Level 3/idle_2.xbm
+    { 2, 1, 23, 0x0410, 40 }, // Level 3/idle_3.xbm
+  },
+  {
+    { 3, 0, no_patch, 0x0000, 34 }, // Level 4/idle_0.xbm
+    { 3, 1, no_patch, 0x0000, 34 }, // Level 4/idle_1.xbm
+    { 3, 2, no_patch, 0x0000, 34 }, // Level 4/idle_2.xbm
+    { 3, 1, no_patch, 0x0000, 40 }, // Level 4/idle_3.xbm
+  },
+};
+
+#endif
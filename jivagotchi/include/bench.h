@@ -0,0 +1,35 @@
+/*
+ * Jiva-gotchi: Rendering Benchmark
+ * Native only. Walks the UI through its screens (home, idle animation, menu, the minigames, feeding)
+ * using the real actions, and reports what each screen costs: frames, draw calls, bytes sent to the
+ * panel and host time. Optionally writes every screen to a PBM file.
+ *
+ * Also times the per-tick cost of the other pets (pets.h) as their number grows.
+*/
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#ifndef ARDUINO
+
+/**
+ * Run
+ *
+ * @param   rounds      How many times to walk through the screens, for timing
+ * @param   capture_dir OPTIONAL - Directory for the PBM captures, NULL for none
+ * @return  Exit status for main()
+ */
+int bench_run(unsigned long rounds, const char *capture_dir);
+
+/**
+ * Pets
+ * Host time of one pets_catch_up() call for 1 to pets_max pets, when no pet is due and when all are
+ *
+ * @param   rounds      Calls per measurement
+ * @return  Exit status for main()
+ */
+int bench_pets(unsigned long rounds);
+
+#endif
+
+#endif
@@ -0,0 +1,31 @@
+/*
+ * Jiva-gotchi: Game Clock
+ * Unix time kept in software on top of millis(), so the game doesn't read the RTC over I2C on every
+ * loop() pass. The RTC is read again every JIV_CLOCK_RESYNC_S seconds to correct millis() drift, and
+ * has to be read after sleeping, since millis() stops while the chip is powered down.
+*/
+
+#ifndef CLOCK_H
+#define CLOCK_H
+
+#include "hal.h"
+
+#ifndef JIV_CLOCK_RESYNC_S
+#define JIV_CLOCK_RESYNC_S 600
+#endif
+
+/**
+ * Now
+ * The current unix time. Never goes backwards, even if a resync finds millis() had run fast.
+ */
+uint32_t clock_now();
+
+/**
+ * Sync
+ * Reads the RTC right away
+ *
+ * @return  The current unix time
+ */
+uint32_t clock_sync();
+
+#endif
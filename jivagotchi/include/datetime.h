@@ -0,0 +1,30 @@
+/*
+ * Jiva-gotchi: DateTime
+ * Covers the part of RTClib's DateTime the game uses. The native backend always uses this one, the Uno
+ * only when it talks to the RTC itself (JIV_TWI_ASYNC, see twi.h) and RTClib isn't linked.
+*/
+
+#ifndef DATETIME_H
+#define DATETIME_H
+
+#include <stdint.h>
+
+class DateTime {
+  public:
+    DateTime(uint32_t t = 946684800UL) : t(t) {}
+    DateTime(uint16_t year, uint8_t month, uint8_t day, uint8_t hour = 0, uint8_t min = 0, uint8_t sec = 0) {
+      // Days since 1970-01-01 in the proleptic Gregorian calendar, in longs for the Uno's 16 bit int
+      int y = year - (month <= 2);
+      int era = y / 400;
+      int yoe = y - era * 400;
+      int doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+      long days = era * 146097L + yoe * 365L + yoe / 4 - yoe / 100 + doy - 719468L;
+      t = days * 86400UL + hour * 3600UL + min * 60UL + sec;
+    }
+    uint32_t unixtime() const { return t; }
+
+  private:
+    uint32_t t;
+};
+
+#endif
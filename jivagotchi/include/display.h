@@ -0,0 +1,129 @@
+/*
+ * Jiva-gotchi: Display Scenes
+ * Every screen is a scene: a callback that can draw the whole frame from scratch. render() drives it
+ * through u8g2's firstPage/nextPage loop, which makes the same scene code work with the full frame
+ * buffer and with the 128/256 byte page buffers (JIV_PAGE_BUFFER=1/2).
+ *
+ * Scenes draw with draw_text/draw_bitmap, which only touch the buffer and note which 8x8 tiles they
+ * covered. With the full frame buffer each frame is committed once, and only the tiles that were
+ * drawn this frame or held something last frame are sent to the panel.
+*/
+
+#ifndef DISPLAY_H
+#define DISPLAY_H
+
+#include "hal.h"
+
+/**
+ * Scene callback
+ * Called once per page, must draw the complete screen each time
+ *
+ * @param   ctx     Whatever state the scene needs, passed through from render()
+ */
+typedef void (*scene_fn)(const void *ctx);
+
+/**
+ * Render
+ * Draws a scene and sends it to the screen
+ *
+ * @param   scene   The scene callback
+ * @param   ctx     OPTIONAL - State handed to the scene (Default: NULL)
+ */
+void render(scene_fn scene, const void *ctx = NULL);
+
+/**
+ * Render Over
+ * Draws an overlay on top of what is already on screen. With the full frame buffer only the overlay is
+ * drawn and flushed; with a page buffer nothing is kept between frames, so the base scene is redrawn
+ * underneath it.
+ *
+ * @param   base        The scene currently on screen
+ * @param   base_ctx    State for the base scene
+ * @param   overlay     The scene to draw on top
+ * @param   overlay_ctx State for the overlay
+ */
+void render_over(scene_fn base, const void *base_ctx, scene_fn overlay, const void *overlay_ctx);
+
+/**
+ * Drawing
+ * For use inside scenes only
+ */
+void draw_text(int posx, int posy, const char *text);
+void draw_text(int posx, int posy, const __FlashStringHelper *text);
+void draw_bitmap(int posx, int posy, int width, int height, const unsigned char *pic);
+void draw_bitmap_ram(int posx, int posy, int width, int height, const unsigned char *pic);
+
+/**
+ * Draw Number
+ * A label, a number and a suffix as one string, e.g. "Happy: 50%", without printf: on the Uno
+ * snprintf alone pulls in several KB of vfprintf.
+ *
+ * @param   label   Text before the number, NULL for none. Up to 16 characters.
+ * @param   value   The number
+ * @param   suffix  OPTIONAL - Character after the number, 0 for none (Default: 0)
+ */
+void draw_number(int posx, int posy, const __FlashStringHelper *label, uint16_t value, char suffix = 0);
+
+/**
+ * Number Text
+ * Writes value in decimal, by subtracting powers of ten rather than dividing
+ *
+ * @param   out     Where the digits go, number_text_max bytes or more
+ * @return  Just past the last digit; nothing is terminated
+ */
+static const uint8_t number_text_max = 5;
+char *number_text(char *out, uint16_t value);
+
+/**
+ * Frame Stats
+ * What the last committed frame cost, and what every frame so far has cost between them. lit_pixels is
+ * how many pixels the frame has on, which the panel's current goes with (power.h).
+ */
+struct frame_stats {
+  uint16_t draw_calls;
+  uint16_t bytes_sent;
+  uint16_t lit_pixels;
+};
+
+struct display_totals {
+  uint32_t frames;
+  uint32_t draw_calls;
+  uint32_t bytes_sent;
+  uint32_t lit_pixels;
+};
+
+const frame_stats& display_last_frame();
+uint32_t display_total_bytes();
+const display_totals& display_total();
+
+/**
+ * Frame Pacing
+ * Frames are held at least 1000 / JIV_FRAME_CAP_HZ ms apart. frame_pace() turns a frame's duration into
+ * how long to wait from now, counted from when the last frame went out, so the time spent drawing doesn't
+ * add up across an animation. In between, the scheduler's deadline lets the CPU idle (hal_yield_until()).
+ *
+ * @param   ms      How long the frame on screen should stay up
+ * @return  Milliseconds until the next frame is due, 0 if it already is
+ */
+#ifndef JIV_FRAME_CAP_HZ
+#define JIV_FRAME_CAP_HZ 30
+#endif
+
+static_assert(JIV_FRAME_CAP_HZ >= 1 && JIV_FRAME_CAP_HZ <= 1000, "JIV_FRAME_CAP_HZ must be 1-1000");
+static const uint32_t frame_min_ms = 1000 / JIV_FRAME_CAP_HZ;
+
+uint32_t frame_pace(uint32_t ms);
+
+/**
+ * Sketch helpers
+ * Simple screens made of flash strings and bitmaps are built up one call at a time into a small
+ * retained scene. Each call is its own frame, unless the calls are wrapped in frame_begin() and
+ * frame_commit(), in which case the screen goes out once at the commit.
+ */
+void frame_begin();
+void frame_commit();
+void clearScreen();
+void printImage(int width, int height, const unsigned char *pic, bool clear = true, int posx = 0, int posy = 0);
+void print_f_text(const __FlashStringHelper* text, bool clear = true, int posx = 0, int posy = 0);
+
+#endif
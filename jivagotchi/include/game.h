@@ -0,0 +1,197 @@
+/*
+ * Jiva-gotchi: Game Core
+ * The tamagotchi itself and everything that happens to it. Hardware access goes through hal.h,
+ * so this compiles for both the Uno and the native host build.
+*/
+
+#ifndef GAME_H
+#define GAME_H
+
+#include "hal.h"
+#include "scheduler.h"
+
+/**
+ * Stat ranges
+ * hunger, happy and discipline are percentages, level goes from 1 to level_max
+ */
+static const uint8_t stat_max = 100;
+static const uint8_t level_max = 4;
+
+/**
+ * Tamagotchi Class
+ * Holds all the values related to the user's tamagotchi
+ * Packed to 14 bytes on the Uno: this is what gets saved, so every byte is an EEPROM write.
+ * birth and ticked (when time last passed for it) are unix times. Stats only change through stat_add(),
+ * which keeps them in range.
+ */
+class tamagotchi {
+
+  public:
+    uint32_t birth;
+    uint32_t ticked;
+    uint8_t hunger;
+    uint8_t happy;
+    uint8_t discipline;
+    uint8_t level;
+    uint8_t snacks_fed;
+    bool health : 1;
+    bool soiled : 1;
+    bool misbehave : 1;
+
+    tamagotchi() {
+      birth = DateTime().unixtime();
+      ticked = birth;
+      hunger = 50;
+      happy = 50;
+      discipline = 0;
+      level = 1;
+      snacks_fed = 0;
+      health = true;
+      soiled = true;
+      misbehave = false;
+    }
+
+};
+
+/**
+ * Global Variables
+ */
+extern uint32_t now, last_action;
+extern tamagotchi jiv;
+extern bool changed;
+extern bool night_sleep;
+extern bool sleep_tama;
+
+/**
+ * Sleep Report
+ * Wake ups and I2C transactions during the last doSleep(), what the battery actually pays for
+ */
+struct sleep_report {
+  uint16_t wakes;
+  uint16_t i2c;
+};
+extern sleep_report last_sleep;
+
+/**
+ * Screens
+ */
+void print_stats(tamagotchi& tama);
+
+/**
+ * Persistence
+ * save_tick() watches for fields that differ from the last save and writes the tama to the RTC's NVRAM
+ * within a second. EEPROM saves are checkpoints and write-behind: once changes have waited
+ * JIV_SAVE_INTERVAL_S seconds or save_soon() was called (level-up), the tama goes out a byte per pass so
+ * the UI never waits on the EEPROM. save_now() writes the NVRAM right away, for going to sleep;
+ * write_eeprom() checkpoints right away, for when nothing is on screen. read_eeprom() takes whichever
+ * tier is newer. checkpoint_hot() makes the pet in the NVRAM copy active and moves that copy into its
+ * journal, for when it is about to be replaced by a new tama. save_switched() tells it the pet on screen was
+ * swapped for one whose journal is up to date, unless behind. While save_busy(), loop() doesn't idle
+ * longer than save_yield_ms, so a staged record goes out at about the EEPROM's own pace.
+ *
+ * These save the active pet (pets.h). save_tick() also writes out the other pets time passed for,
+ * save_pets() does the same right away, read_pets() loads every other pet that has a save.
+ */
+#ifndef JIV_SAVE_INTERVAL_S
+#define JIV_SAVE_INTERVAL_S 3600
+#endif
+
+static const uint32_t save_yield_ms = 4;
+
+enum save_field {
+  save_hunger = 1 << 0,
+  save_happy = 1 << 1,
+  save_discipline = 1 << 2,
+  save_level = 1 << 3,
+  save_health = 1 << 4,
+  save_soiled = 1 << 5,
+  save_misbehave = 1 << 6,
+  save_snacks_fed = 1 << 7,
+  save_birth = 1 << 8,
+  save_ticked = 1 << 9
+};
+
+void write_eeprom(tamagotchi& tama);
+bool read_eeprom(tamagotchi& tama);
+void save_tick(tamagotchi& tama);
+void save_soon();
+void save_switched(const tamagotchi& tama, bool behind);
+bool save_busy();
+void save_now(tamagotchi& tama);
+void save_pets();
+void read_pets();
+void checkpoint_hot();
+uint16_t save_dirty(const tamagotchi& tama);
+
+/**
+ * Stat Add
+ * Saturating add, the stat ends up within [0, max]
+ *
+ * @param   stat    The stat to change
+ * @param   delta   How much to add, negative to take away
+ * @param   max     OPTIONAL - Upper bound (Default: stat_max)
+ */
+static inline void stat_add(uint8_t& stat, int delta, uint8_t max = stat_max) {
+  int value = stat + delta;
+  stat = (value < 0) ? 0 : (value > max) ? max : value;
+}
+
+/**
+ * Game rules
+ */
+void passTime(tamagotchi& tama);
+void passTimes(tamagotchi& tama, uint32_t intervals);
+
+/**
+ * Catch Up
+ * Applies every 30 minute interval between tama.ticked and time in one go, and moves tama.ticked on
+ *
+ * @param   tama    The tamagotchi object to be processed
+ * @param   time    The current unix time
+ * @return  Whether any time passed for it
+ */
+static const uint32_t tick_interval = 1800;
+bool catchUp(tamagotchi& tama, uint32_t time);
+void doSleep(tamagotchi& tama);
+
+/**
+ * Care rules
+ * What the activities and level ups do to the stats, without the screens around them. The actions call
+ * these and so does the balance simulator (sim.h), so both play by the same rules. The care_ functions
+ * return false when the tama didn't need it (heal, scold, clean) or wouldn't take it (feeding a
+ * misbehaving tama); that can still cost happiness.
+ *
+ * level_up_due() is when loop() starts a level up: old enough since the last one and in good standing.
+ * A night's sleep ends at night_morning(), and night_over() skips the intervals it covered.
+ */
+bool good_standing(const tamagotchi& tama);
+bool level_up_due(const tamagotchi& tama, uint32_t time);
+void care_level_up(tamagotchi& tama, uint32_t time);
+void care_over_under(tamagotchi& tama);
+void care_right_left(tamagotchi& tama);
+bool care_heal(tamagotchi& tama);
+bool care_scold(tamagotchi& tama);
+bool care_clean(tamagotchi& tama);
+bool care_meal(tamagotchi& tama);
+bool care_snack(tamagotchi& tama);
+uint32_t night_morning(const tamagotchi& tama);
+void night_over(tamagotchi& tama, uint32_t morning);
+
+/**
+ * Actions
+ * Scheduler step functions (scheduler.h), started with the tamagotchi as ctx
+ */
+void overUnder(action& act);
+void rightLeft(action& act);
+void heal(action& act);
+void scold(action& act);
+void clean(action& act);
+void feed(action& act);
+void level_up(action& act);
+void idle_ani(action& act);
+void glance(action& act);
+void tuck_in(action& act);
+void next_pet(action& act);
+void menu(action& act);  // main.cpp
+
+#endif
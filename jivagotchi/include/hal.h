@@ -0,0 +1,161 @@
+/*
+ * Jiva-gotchi: Hardware Abstraction Layer
+ * Everything the game needs from the outside world (clock, buttons, storage, randomness, display, sleep)
+ * goes through the functions declared here. The Uno backend lives in hal_avr.cpp, the Linux
+ * backend used by [env:native] lives in hal_native.cpp.
+*/
+
+#ifndef HAL_H
+#define HAL_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#include <avr/pgmspace.h>
+#if JIV_TWI_ASYNC
+#include "datetime.h"
+#else
+#include <RTClib.h>
+#endif
+#else
+#include "hal_native.h"
+#endif
+
+/**
+ * Pin Definitions
+ */
+
+#define buttonA 2
+#define buttonB 3
+#define buttonC 4
+
+/**
+ * Board setup
+ * Brings up serial, the display, the buttons and the RNG
+ *
+ * @return  False if the RTC could not be found
+ */
+bool hal_begin();
+
+/**
+ * Clock
+ * hal_rtc_now() reads the RTC over I2C
+ */
+uint32_t hal_millis();
+void hal_delay(uint32_t ms);
+DateTime hal_rtc_now();
+
+/**
+ * Yield
+ * Nothing is due before millis() reaches ms. The backend may idle until then; returning early is fine.
+ *
+ * @param   ms      The next deadline, in millis()
+ */
+void hal_yield_until(uint32_t ms);
+
+/**
+ * Input
+ * Returns true while the given button is held down
+ *
+ * @param   pin     One of buttonA, buttonB, buttonC
+ */
+bool hal_pressed(uint8_t pin);
+
+/**
+ * Storage
+ * Raw access to the non-volatile save area
+ */
+void hal_storage_read(int address, void *data, size_t len);
+void hal_storage_write(int address, const void *data, size_t len);
+
+template <typename T> void hal_storage_get(int address, T& value) {
+  hal_storage_read(address, &value, sizeof(T));
+}
+
+template <typename T> void hal_storage_put(int address, const T& value) {
+  hal_storage_write(address, &value, sizeof(T));
+}
+
+/**
+ * Entropy
+ * A seed for rng.h that should differ from one power on to the next. Slow (about 130 ms on the Uno),
+ * meant to be called once from setup().
+ */
+uint32_t hal_entropy();
+
+/**
+ * Display
+ * Thin wrappers over the u8g2 calls the game makes. Drawing happens between hal_display_first_page()
+ * and hal_display_next_page() returning false; with a page buffer the same drawing is repeated for
+ * every page. Build with -D JIV_PAGE_BUFFER=1 or 2 to use the 128/256 byte page buffer instead of the
+ * 1 KB full frame buffer.
+ *
+ * With the full frame buffer the buffer can also be cleared and sent a tile area at a time
+ * (hal_display_clear_buffer, hal_display_update_area), where tiles are 8x8 pixels. The send may still
+ * be going when update_area returns (JIV_TWI_ASYNC, see twi.h); the next drawing call waits for it.
+ *
+ * hal_display_buffer() is what has been drawn so far: the whole screen with the full frame buffer, the
+ * current page with a page buffer, in the panel's layout of one byte per 8 pixel column.
+ */
+void hal_display_first_page();
+bool hal_display_next_page();
+void hal_display_clear_buffer();
+void hal_display_update_area(uint8_t tx, uint8_t ty, uint8_t tw, uint8_t th);
+void hal_display_bitmap(int posx, int posy, int width, int height, const unsigned char *pic);
+void hal_display_bitmap_ram(int posx, int posy, int width, int height, const unsigned char *pic);
+void hal_display_text(int posx, int posy, const char *text);
+void hal_display_text(int posx, int posy, const __FlashStringHelper *text);
+int hal_display_text_width(const char *text);
+int hal_display_text_width(const __FlashStringHelper *text);
+int hal_display_ascent();
+int hal_display_descent();
+void hal_display_power_save(bool enable);
+void hal_display_contrast(uint8_t level);
+const uint8_t *hal_display_buffer(uint16_t& len);
+
+/**
+ * Sleep
+ * hal_sleep_begin/hal_sleep_end bracket a low power period. hal_sleep_wait sleeps for one watchdog period
+ * of roughly hal_sleep_period_s seconds (the watchdog oscillator is only good to about 10%), or with
+ * timed false until the wake button with the watchdog off.
+ *
+ * @param   timed   Wake up after one watchdog period as well
+ * @return  hal_sleep_wait returns true if the wake button ended the sleep
+ */
+static const uint8_t hal_sleep_period_s = 8;
+
+void hal_sleep_begin();
+bool hal_sleep_wait(bool timed);
+void hal_sleep_end();
+
+/**
+ * Serial
+ * Binary output for telemetry.h at hal_serial_baud. hal_serial_write never waits: the data goes into a
+ * TX ring that the UART drains in the background, and the caller checks hal_serial_free() first so that
+ * nothing has to be cut short. Before sleeping the backend lets the ring drain (64 bytes at 250 kbaud is
+ * 2.6 ms).
+ */
+static const uint32_t hal_serial_baud = 250000;
+
+uint8_t hal_serial_free();
+void hal_serial_write(const uint8_t *data, uint8_t len);
+
+/**
+ * RTC NVRAM
+ * The DS1307's battery backed RAM: no wear, one I2C write however many bytes. Lost along with the time
+ * when the coin cell is. Up to 31 bytes a call, what one Wire transaction holds.
+ */
+static const uint8_t hal_nvram_size = 56;
+
+void hal_nvram_read(uint8_t address, void *data, uint8_t len);
+void hal_nvram_write(uint8_t address, const void *data, uint8_t len);
+
+/**
+ * Bus Counter
+ * I2C transactions made for the RTC and the display's power save so far, to measure what sleep costs
+ */
+uint32_t hal_i2c_count();
+
+#endif
@@ -0,0 +1,71 @@
+/*
+ * Jiva-gotchi: Native Backend
+ * Stand-ins for the Arduino/AVR pieces the game touches, plus hooks for driving the native backend
+ * (virtual clock, scripted buttons, in-memory EEPROM) from a host program
+*/
+
+#ifndef HAL_NATIVE_H
+#define HAL_NATIVE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdio.h>
+#include "datetime.h"
+
+/**
+ * Flash memory shims
+ * There is only one address space on the host, so PROGMEM data is read directly
+ */
+#define PROGMEM
+#define pgm_read_byte(addr) (*(const uint8_t *)(addr))
+#define pgm_read_word(addr) (*(const uint16_t *)(addr))
+#define pgm_read_ptr(addr) (*(void * const *)(addr))
+#define memcpy_P memcpy
+#define strlen_P strlen
+
+/**
+ * CRC shim
+ * Same as avr-libc's _crc_ccitt_update from util/crc16.h
+ */
+static inline uint16_t _crc_ccitt_update(uint16_t crc, uint8_t data) {
+  data ^= crc & 0xFF;
+  data ^= data << 4;
+  return ((((uint16_t)data << 8) | (crc >> 8)) ^ (uint8_t)(data >> 4) ^ ((uint16_t)data << 3));
+}
+
+// Same as _crc8_ccitt_update (polynomial 0x07)
+static inline uint8_t _crc8_ccitt_update(uint8_t crc, uint8_t data) {
+  crc ^= data;
+  for (uint8_t i = 0; i < 8; i++) {
+    crc = (crc & 0x80) ? (crc << 1) ^ 0x07 : crc << 1;
+  }
+  return crc;
+}
+
+class __FlashStringHelper;
+#define F(string_literal) (reinterpret_cast<const __FlashStringHelper *>(string_literal))
+
+/**
+ * Backend hooks
+ */
+
+// Button script, asked whether a pin is held down at the given virtual time
+typedef bool (*hal_native_input)(uint8_t pin, uint32_t ms);
+
+void hal_native_set_input(hal_native_input input);
+void hal_native_set_rtc(uint32_t unixtime);
+void hal_native_advance(uint32_t ms);
+void hal_native_set_entropy(uint32_t seed);  // what hal_entropy() returns
+
+// Where the serial telemetry goes; NULL (the default) throws it away
+void hal_native_set_serial(FILE *out);
+
+// What's on the simulated panel: the raw 1 KB of it, one pixel, or the whole screen written to a PBM file.
+// And the contrast it was last set to.
+const uint8_t *hal_native_panel();
+uint8_t hal_native_contrast();
+bool hal_native_pixel(int x, int y);
+bool hal_native_capture(const char *path);
+
+#endif
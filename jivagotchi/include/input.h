@@ -0,0 +1,76 @@
+/*
+ * Jiva-gotchi: Input Events
+ * Button edges come in from the pin change interrupt (or the native backend) through input_edge(),
+ * get debounced, and land in a small ring buffer as timestamped press/release events. Holding a button
+ * adds a long press event. Menus and minigames read events instead of sampling the pins, so a press
+ * is never missed between polls and never counted twice.
+*/
+
+#ifndef INPUT_H
+#define INPUT_H
+
+#include "hal.h"
+
+enum input_type {
+  input_press,
+  input_release,
+  input_long_press
+};
+
+struct input_event {
+  uint8_t button;
+  uint8_t type;
+  uint32_t ms;
+};
+
+// Edges closer together than this are contact bounce
+static const uint8_t input_debounce_ms = 20;
+// How long a button has to be held for a long press
+static const uint16_t input_long_press_ms = 800;
+
+/**
+ * Edge
+ * Called from the pin change interrupt (or the native backend) when a button changes
+ *
+ * @param   button  One of buttonA, buttonB, buttonC
+ * @param   pressed The new state of the button
+ * @param   ms      millis() when it changed
+ */
+void input_edge(uint8_t button, bool pressed, uint32_t ms);
+
+/**
+ * Read
+ * Takes the oldest event off the queue
+ *
+ * @param   event   Filled in with the event
+ * @return  False if there was nothing queued
+ */
+bool input_read(input_event& event);
+
+/**
+ * Next Press
+ * Takes events off the queue until a press turns up
+ *
+ * @return  The button that was pressed, 0 if there was no press queued
+ */
+uint8_t input_next_press();
+
+/**
+ * Last Edge
+ * millis() when a button last went down or up, 0 if none has yet
+ */
+uint32_t input_last_edge();
+
+/**
+ * Queued
+ * Whether an event is waiting, without taking it off the queue
+ */
+bool input_queued();
+
+/**
+ * Flush
+ * Drops everything queued, e.g. presses made before a prompt was on screen
+ */
+void input_flush();
+
+#endif
@@ -0,0 +1,82 @@
+/*
+ * Jiva-gotchi: Save Journal
+ * Instead of rewriting the same EEPROM cells on every save, saves go round-robin through fixed size
+ * slots. Each record carries a sequence number and a CRC; reading picks the newest record whose CRC
+ * checks out, so a save cut short by a power loss falls back to the one before it.
+ *
+ * Slot layout: uint16_t seq, uint16_t crc, payload. The CRC covers seq, the payload length and the payload.
+*/
+
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include "hal.h"
+
+static const uint16_t journal_eeprom_size = 1024;
+static const uint8_t journal_slot_size = 32;
+static const uint8_t journal_header_size = 4;
+static const uint8_t journal_payload_size = journal_slot_size - journal_header_size;
+
+/**
+ * Journal
+ * An area of EEPROM split into slots, plus where the newest record was found and the record being
+ * written, if any. pending counts the bytes still to go: payload, then CRC, then sequence number.
+ */
+struct journal {
+  int base;
+  uint8_t slots;
+  uint8_t newest;
+  uint16_t seq;
+  bool valid;
+
+  uint8_t record[journal_header_size + journal_payload_size];
+  uint8_t len;
+  uint8_t pending;
+};
+
+/**
+ * Open
+ * Scans the slots for the newest valid record
+ *
+ * @param   j       The journal
+ * @param   base    EEPROM address of the first slot
+ * @param   slots   How many slots the journal spans
+ * @param   len     Payload length of the records
+ */
+void journal_open(journal& j, int base, uint8_t slots, uint8_t len);
+
+/**
+ * Read
+ * Copies the newest valid record
+ *
+ * @return  False if the journal holds no valid record
+ */
+bool journal_read(const journal& j, void *data, uint8_t len);
+
+/**
+ * Write
+ * Appends a record in the slot after the newest one. Nothing is written if the payload is the same as
+ * the newest record.
+ */
+void journal_write(journal& j, const void *data, uint8_t len);
+
+/**
+ * Staged Write
+ * journal_write() split up so the EEPROM's ~3.3 ms per byte can be spread over many loop() passes:
+ * journal_stage() copies the record (finishing any record still staged), journal_step() writes the next
+ * few bytes of it. A staged record is only read back once its last byte is written.
+ *
+ * @param   max_bytes   How many bytes journal_step() may write
+ * @return  journal_stage: false if there was nothing to write. journal_step: true once the record is done.
+ */
+bool journal_stage(journal& j, const void *data, uint8_t len);
+bool journal_step(journal& j, uint8_t max_bytes);
+bool journal_pending(const journal& j);
+
+/**
+ * Next Sequence Number
+ * What the newest record's sequence number will be once the staged one, if any, is written
+ */
+uint16_t journal_next_seq(const journal& j);
+
+#endif
@@ -0,0 +1,64 @@
+/*
+ * Jiva-gotchi: Pets
+ * Every pet on the device, kept as a struct of arrays: one array per field, the flags as one bit per
+ * pet. A pet costs 14 bytes of SRAM, the same as a tamagotchi, and the time check that runs every loop()
+ * pass only walks the ticked array.
+ *
+ * The pet on screen lives in jiv, like before; its row in the store is brought up to date when another
+ * pet takes its place. Build with -D JIV_PETS=<n> (1 - 8) to change how many pets there are room for.
+ * Each pet has its own share of the EEPROM save journal (save.cpp).
+*/
+
+#ifndef PETS_H
+#define PETS_H
+
+#include "game.h"
+
+#ifndef JIV_PETS
+#define JIV_PETS 4
+#endif
+
+static const uint8_t pets_max = JIV_PETS;
+static const uint8_t pet_none = 0xFF;
+
+static_assert(JIV_PETS >= 1 && JIV_PETS <= 8, "JIV_PETS must be 1 - 8, the flags are one byte");
+
+struct pet_store {
+  uint32_t birth[pets_max];
+  uint32_t ticked[pets_max];
+  uint8_t hunger[pets_max];
+  uint8_t happy[pets_max];
+  uint8_t discipline[pets_max];
+  uint8_t level[pets_max];
+  uint8_t snacks_fed[pets_max];
+  uint8_t health;
+  uint8_t soiled;
+  uint8_t misbehave;
+  uint8_t used;    // slots holding a pet
+  uint8_t dirty;   // slots changed since they were last saved
+};
+
+extern pet_store pets;
+extern uint8_t active_pet;
+
+/**
+ * Get / Put
+ * Copy a pet between the store and a tamagotchi. Putting marks the slot used.
+ *
+ * @return  pets_get: false if the slot is empty
+ */
+bool pets_get(uint8_t slot, tamagotchi& tama);
+void pets_put(uint8_t slot, const tamagotchi& tama);
+
+/**
+ * Catch Up
+ * catchUp() for every stored pet but one, in a single pass. Pets that have an interval due are run
+ * through the same rules as the pet on screen and marked dirty.
+ *
+ * @param   time    The current unix time
+ * @param   skip    The slot to leave alone (the one in jiv), pet_none for none
+ * @return  The slots time passed for, one bit each
+ */
+uint8_t pets_catch_up(uint32_t time, uint8_t skip);
+
+#endif
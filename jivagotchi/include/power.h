@@ -0,0 +1,41 @@
+/*
+ * Jiva-gotchi: Display Power
+ * An OLED draws current for every lit pixel, more the higher the contrast. The longer nobody touches a
+ * button, the lower the contrast goes, and for the last stretch before sleep (game.cpp, doSleep) the idle
+ * animation gives way to the glance screen: the level and a mark if the pet needs something, a few dozen
+ * pixels instead of the whole home screen. Any press brings the full screen back.
+ *
+ * What a frame lights up is counted from the buffer as it is drawn (display.h, frame_stats.lit_pixels),
+ * so the bench and the native run can put a number on what a screen costs.
+*/
+
+#ifndef POWER_H
+#define POWER_H
+
+#include "hal.h"
+
+// Idle seconds before the glance screen; the contrast steps down at a third and two thirds of that
+#ifndef JIV_GLANCE_S
+#define JIV_GLANCE_S 180
+#endif
+
+static_assert(JIV_GLANCE_S >= 3 && JIV_GLANCE_S < 300, "JIV_GLANCE_S must be 3 - 299, before the tama sleeps");
+
+enum power_stage {
+  power_full,
+  power_dim,
+  power_dimmer,
+  power_glance
+};
+
+/**
+ * Tick
+ * Moves to the stage for this much idle time, setting the contrast if it changed
+ *
+ * @param   idle_s  Seconds since the last press or activity
+ * @return  The stage now in effect
+ */
+uint8_t power_tick(uint32_t idle_s);
+uint8_t power_stage();
+
+#endif
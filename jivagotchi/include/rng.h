@@ -0,0 +1,36 @@
+/*
+ * Jiva-gotchi: Random Numbers
+ * A xorshift32 generator for the game rules and minigames. It uses shifts and XORs only, where
+ * Arduino's random() needs 32-bit divisions on the Uno, and the whole stream follows from the seed.
+ * setup() seeds it from hal_entropy() and reports the seed over telemetry. To replay a bug report, build
+ * with -D JIV_RNG_SEED=<seed> (the seed argument on the native build) and the tama rolls the same dice.
+ *
+ * On the host every thread has its own generator, for the balance simulator.
+*/
+
+#ifndef RNG_H
+#define RNG_H
+
+#include <stdint.h>
+
+/**
+ * Seed
+ * Every seed gives a different stream, including 0. rng_seed_used() is the last seed given, for reports.
+ *
+ * @param   seed    The seed
+ */
+void rng_seed(uint32_t seed);
+uint32_t rng_seed_used();
+
+/**
+ * Draws
+ * rng_next() is the full 32 bits and rng_u16() the top 16 of them, uniform over [0, 65536).
+ * rng_below(n) is in [0, n), found by scaling rather than division, and 0 when n is 0.
+ * rng_range(min, max) is in [min, max), and min when the range is empty.
+ */
+uint32_t rng_next();
+uint16_t rng_u16();
+uint16_t rng_below(uint16_t n);
+int16_t rng_range(int16_t min, int16_t max);
+
+#endif
@@ -0,0 +1,84 @@
+/*
+ * Jiva-gotchi: Cooperative Scheduler
+ * Long running things (actions, minigames, the menu, the idle animation) are state machines instead of
+ * functions that delay() and spin on buttons. An action's run() does one step and then says when it wants
+ * to run again: after some milliseconds, or once a button is pressed. loop() ticks the current action,
+ * and in between the rest of the game keeps running and the CPU is free to idle.
+*/
+
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include "hal.h"
+#include "input.h"
+
+struct action;
+
+/**
+ * Action step
+ * Called when the action is due, with act.step saying where it left off
+ *
+ * @param   act     The running action
+ */
+typedef void (*action_fn)(action& act);
+
+/**
+ * Action
+ * run is NULL when nothing is running. ctx is handed through from action_start() untouched.
+ */
+struct action {
+  action_fn run;
+  void *ctx;
+  uint8_t step;
+  uint8_t button;
+  uint32_t due;
+};
+
+// How often a step waiting on input looks at the event queue
+static const uint32_t button_poll_ms = 10;
+
+/**
+ * Start Action
+ * Replaces whatever the slot was running; the first step runs on the next tick
+ *
+ * @param   act     The action slot
+ * @param   run     The step function
+ * @param   ctx     OPTIONAL - State for the step function (Default: NULL)
+ */
+void action_start(action& act, action_fn run, void *ctx = NULL);
+
+/**
+ * Waits
+ * Call from a step to say what happens next. A step that doesn't wait is run again straight away.
+ * A button wait only counts presses made after it started.
+ *
+ * @param   act         The running action
+ * @param   ms          Milliseconds until next_step runs
+ * @param   button      Button that has to be pressed before next_step runs
+ * @param   next_step   The step to continue with
+ */
+void action_wait(action& act, uint32_t ms, uint8_t next_step);
+void action_wait_button(action& act, uint8_t button, uint8_t next_step);
+
+/**
+ * Done
+ * Ends the action, the slot is free again
+ */
+void action_done(action& act);
+
+/**
+ * Tick
+ * Runs the action's next step if it is due
+ *
+ * @return  True if a step ran
+ */
+bool action_tick(action& act);
+
+/**
+ * State
+ */
+bool action_busy(const action& act);
+bool action_running(const action& act, action_fn run);
+uint32_t action_due(const action& act);
+
+#endif
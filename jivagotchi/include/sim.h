@@ -0,0 +1,27 @@
+/*
+ * Jiva-gotchi: Balance Simulator
+ * Native only. Plays out many lifetimes of a tama under scripted owners (how often they check in, what
+ * they do when they do) and reports how soon it reaches each level, how often it is found sick, and how
+ * its stats are spread. Time passes through catchUp() and care goes through the care rules in game.h,
+ * the same code the game runs, so tuning those shows up here unchanged.
+*/
+
+#ifndef SIM_H
+#define SIM_H
+
+#ifndef ARDUINO
+
+/**
+ * Run
+ * Lifetime i is seeded from seed and i alone, so the results don't depend on the number of threads
+ *
+ * @param   lifetimes   How many lifetimes per owner
+ * @param   threads     Worker threads, 0 for one per core
+ * @param   seed        Base random seed
+ * @return  Exit status for main()
+ */
+int sim_run(unsigned long lifetimes, unsigned threads, unsigned long seed);
+
+#endif
+
+#endif
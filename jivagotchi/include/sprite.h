@@ -0,0 +1,68 @@
+/*
+ * Jiva-gotchi: Sprite Engine
+ * Idle frames are the level's base sprite moved down a few rows, sometimes with one row touched up
+ * (level 3's legs). Instead of a bitmap per frame, the atlas keeps each distinct bitmap once,
+ * RLE-compressed, plus a small table of per-frame offsets, patches and timings in flash. Both are
+ * generated from art/ by tools/gen_assets.py into assets.h. Frames are decompressed into RAM when drawn.
+*/
+
+#ifndef SPRITE_H
+#define SPRITE_H
+
+#include "hal.h"
+
+static const uint8_t sprite_width = 16;
+static const uint8_t sprite_height = 24;
+static const uint8_t sprite_bytes = sprite_width / 8 * sprite_height;
+static const uint8_t idle_frames = 4;
+static const uint8_t no_patch = 0xFF;
+
+/**
+ * Frame entries
+ * bitmap:      Index into the atlas
+ * dy:          Rows the bitmap is moved down (the bottom rows fall off)
+ * patch_row:   Row XORed with patch after moving, no_patch for none
+ * patch:       Bits to flip in that row, in XBM order (bit 0 is the leftmost pixel)
+ * ms:          Time on screen
+ */
+struct sprite_frame {
+  uint8_t bitmap;
+  uint8_t dy;
+  uint8_t patch_row;
+  uint16_t patch;
+  uint8_t ms;
+};
+
+/**
+ * Compose Sprite
+ * Builds an idle frame as an XBM bitmap in RAM
+ *
+ * @param   level   Tama level, 1 - 4
+ * @param   frame   Idle frame, 0 - 3
+ * @param   out     sprite_bytes of space for the bitmap
+ * @return  False if there is no such sprite
+ */
+bool sprite_compose(uint8_t level, uint8_t frame, unsigned char *out);
+
+/**
+ * Frame Time
+ * How long an idle frame stays on screen
+ *
+ * @param   level   Tama level, 1 - 4
+ * @param   frame   Idle frame, 0 - 3
+ * @return  Milliseconds, 0 if there is no such sprite
+ */
+uint8_t sprite_frame_ms(uint8_t level, uint8_t frame);
+
+/**
+ * Draw Sprite
+ * Draws an idle frame; for use inside scenes
+ *
+ * @param   posx    X Position of the sprite
+ * @param   posy    Y Position of the sprite
+ * @param   level   Tama level, 1 - 4
+ * @param   frame   Idle frame, 0 - 3
+ */
+void draw_sprite(int posx, int posy, uint8_t level, uint8_t frame);
+
+#endif
@@ -0,0 +1,55 @@
+/*
+ * Jiva-gotchi: Telemetry
+ * Field diagnostics as small binary frames on the serial port, decoded on the host by
+ * tools/telemetry.py. Frames go into the HAL's TX ring and out in the background, so sending one never
+ * stalls the game loop. When the ring has no room for a whole frame the frame is dropped and counted,
+ * and the count rides along in the next state record.
+ *
+ * Frame: 0xA5, type, payload length, payload, CRC-8 (polynomial 0x07) over type, length and payload.
+ * Every payload starts with hal_millis() as a uint32_t; all fields are little-endian.
+*/
+
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include "game.h"
+
+static const uint8_t telemetry_sync = 0xA5;
+
+/**
+ * Record types
+ * state: ms, now, birth, ticked (uint32_t), hunger, happy, discipline, level, snacks_fed, flags
+ *        (bit 0 health, bit 1 soiled, bit 2 misbehave, bits 5-7 the active pet), frames dropped so far
+ *        (uint16_t)
+ * event: ms, code, arg (uint16_t)
+ * sleep: ms, wakes, I2C transactions (uint16_t)
+ * seed:  ms, the seed rng.h was started from (uint32_t)
+ */
+enum telemetry_record {
+  record_state = 1,
+  record_event = 2,
+  record_sleep = 3,
+  record_seed = 4
+};
+
+/**
+ * Event codes
+ * What arg carries is noted next to each
+ */
+enum telemetry_event_code {
+  event_boot = 1,      // 2 if a save was resumed, 1 if loaded at the prompt, 0 for a new tama
+  event_no_rtc = 2,
+  event_action = 3,    // menu entry picked
+  event_level_up = 4,  // new level
+  event_sleep = 5,     // 1 for the night, 0 for a nap
+  event_wake = 6,      // 1 if the button ended it
+  event_save = 7       // save_field bits that were dirty
+};
+
+void telemetry_state(const tamagotchi& tama);
+void telemetry_event(uint8_t code, uint16_t arg = 0);
+void telemetry_sleep(const sleep_report& report);
+void telemetry_seed(uint32_t seed);
+uint16_t telemetry_dropped();
+
+#endif
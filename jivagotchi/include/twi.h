@@ -0,0 +1,69 @@
+/*
+ * Jiva-gotchi: I2C Transfer Engine
+ * Uno only, built with -D JIV_TWI_ASYNC=1. Runs the bus from the TWI interrupt, so the CPU doesn't sit
+ * out transfers: panel writes go out in the background straight from the frame buffer, whatever else
+ * u8x8 sends is copied into a message slot first, and register reads (the RTC) get the bus as soon as
+ * the transaction on it is done. The panel runs at 400 kHz; the DS1307 only manages 100 kHz, so reads
+ * say how fast to go.
+ *
+ * This takes the place of Wire. Both define the TWI interrupt, so Wire, and RTClib on top of it, can't
+ * be linked next to it (see [env:uno_async] in platformio.ini).
+*/
+
+#ifndef TWI_H
+#define TWI_H
+
+#if defined(ARDUINO) && JIV_TWI_ASYNC
+
+#include "hal.h"
+
+static const uint32_t twi_fast_hz = 400000;
+static const uint32_t twi_standard_hz = 100000;
+static const uint8_t twi_message_max = 32;  // the most u8x8 sends in one transaction, sized for Wire
+static const uint8_t twi_timeout_ms = 100;  // longer than a full queue takes to go out
+
+void twi_begin();
+
+/**
+ * Panel Write
+ * Queues one run along a page of an SH1106/SSD1306 style panel: column and page commands, then len
+ * bytes read from data as they are sent. Waits only if the queue is full.
+ *
+ * @param   address     7 bit device address
+ * @param   page        Panel page (8 pixel band)
+ * @param   column      First panel column, including the controller's offset
+ * @param   data        Must stay unchanged until twi_panel_wait() has returned
+ */
+void twi_panel_write(uint8_t address, uint8_t page, uint8_t column, const uint8_t *data, uint8_t len);
+void twi_panel_wait();
+
+/**
+ * Messages
+ * A write transaction put together piece by piece, as u8x8's byte callback hands it over, and sent once
+ * it ends. Goes out after the panel writes queued before it; anything past twi_message_max is dropped,
+ * as Wire would.
+ */
+void twi_message_begin(uint8_t address);
+void twi_message_add(const uint8_t *data, uint8_t len);
+void twi_message_end();
+
+/**
+ * Register Read / Write
+ * Writes the register number, then reads len bytes after a repeated start, or writes len more bytes.
+ * Blocks, but only behind the transaction already on the bus.
+ *
+ * @param   hz      Bus clock for this transaction
+ * @return  False if the device didn't answer or the bus hung
+ */
+bool twi_read(uint8_t address, uint8_t reg, uint8_t *data, uint8_t len, uint32_t hz);
+bool twi_write(uint8_t address, uint8_t reg, const uint8_t *data, uint8_t len, uint32_t hz);
+
+/**
+ * Wait
+ * Until nothing is queued or on the bus, before the TWI is stopped by sleeping
+ */
+void twi_wait();
+
+#endif
+
+#endif
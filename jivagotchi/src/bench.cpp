@@ -0,0 +1,222 @@
+/*
+ * Jiva-gotchi: Rendering Benchmark
+ * Each screen is one scheduler tick that commits at least one frame. Time is virtual, so waits are
+ * skipped by advancing the clock to when the action is due; button presses go straight into the input
+ * queue. Draw calls and bytes only depend on the code, host time is for spotting regressions between
+ * runs on the same machine.
+ *
+ * bench_pets() times pets_catch_up() on its own, for one pet up to pets_max.
+*/
+
+#ifndef ARDUINO
+
+#include "bench.h"
+#include "game.h"
+#include "display.h"
+#include "input.h"
+#include "rng.h"
+#include "pets.h"
+#include "power.h"
+#include <stdio.h>
+#include <chrono>
+
+struct bench_screen {
+  const char *name;
+  uint32_t frames;
+  uint32_t draw_calls;
+  uint32_t bytes_sent;
+  uint32_t lit_pixels;
+  double seconds;
+};
+
+static const uint8_t screens_max = 24;
+static bench_screen screens[screens_max];
+static uint8_t screen_count = 0;
+static uint8_t screen_index = 0;
+static const char *capture_to = NULL;
+static action slot;
+
+/**
+ * Record
+ * Adds what a screen cost to its row, and captures it on the first round
+ */
+static void record(const char *name, const display_totals& before, double seconds) {
+  if (screen_index == screen_count) {
+    screens[screen_count].name = name;
+    screen_count++;
+
+    if (capture_to != NULL) {
+      char path[256];
+      snprintf(path, sizeof(path), "%s/%02u-%s.pbm", capture_to, (unsigned)screen_index, name);
+      if (!hal_native_capture(path)) {
+        fprintf(stderr, "Couldn't write %s\n", path);
+      }
+    }
+  }
+
+  bench_screen& screen = screens[screen_index++];
+  const display_totals& after = display_total();
+  screen.frames += after.frames - before.frames;
+  screen.draw_calls += after.draw_calls - before.draw_calls;
+  screen.bytes_sent += after.bytes_sent - before.bytes_sent;
+  screen.lit_pixels += after.lit_pixels - before.lit_pixels;
+  screen.seconds += seconds;
+}
+
+/**
+ * Screen
+ * Ticks the action until it puts a frame on screen
+ */
+static void screen(const char *name) {
+  display_totals before = display_total();
+  double seconds = 0;
+
+  for (uint8_t tries = 0; tries < 100 && display_total().frames == before.frames; tries++) {
+    int32_t wait = action_due(slot) - hal_millis();
+    if (wait > 0) {
+      hal_native_advance(wait);
+    }
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    action_tick(slot);
+    seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  }
+  record(name, before, seconds);
+}
+
+/**
+ * Press
+ * A debounced press and release of a button
+ */
+static void press(uint8_t button) {
+  hal_native_advance(input_debounce_ms);
+  input_edge(button, true, hal_millis());
+  hal_native_advance(input_debounce_ms);
+  input_edge(button, false, hal_millis());
+}
+
+/**
+ * Walk
+ * One pass through every screen, starting from a blank panel
+ */
+static void walk() {
+  screen_index = 0;
+  jiv = tamagotchi();
+  changed = false;
+  clearScreen();
+
+  display_totals before = display_total();
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  print_stats(jiv);
+  record("home", before, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+
+  action_start(slot, idle_ani, &jiv);
+  for (uint8_t frame = 0; frame < 4; frame++) {
+    screen("idle");
+  }
+
+  action_start(slot, menu, &jiv);
+  screen("menu");
+  press(buttonB);
+  screen("menu-scroll");
+  press(buttonC);
+  screen("menu-pick");
+
+  action_start(slot, overUnder, &jiv);
+  screen("over-under");
+  press(buttonA);
+  screen("over-under-guess");
+  press(buttonC);
+  screen("over-under-verdict");
+  screen("over-under-close");
+
+  action_start(slot, rightLeft, &jiv);
+  screen("right-left");
+  press(buttonB);
+  screen("right-left-guess");
+  press(buttonC);
+  screen("right-left-verdict");
+
+  action_start(slot, feed, &jiv);
+  screen("feed");
+  press(buttonB);
+  screen("feed-snack");
+
+  action_start(slot, heal, &jiv);
+  screen("heal");
+
+  power_tick(JIV_GLANCE_S);
+  action_start(slot, glance, &jiv);
+  screen("glance");
+  power_tick(0);
+  action_done(slot);
+}
+
+int bench_run(unsigned long rounds, const char *capture_dir) {
+  hal_begin();
+
+  capture_to = capture_dir;
+  for (unsigned long round = 0; round < rounds; round++) {
+    rng_seed(round);
+    walk();
+    capture_to = NULL;
+  }
+
+  printf("%-20s %8s %8s %8s %8s %10s\n", "screen", "frames", "draws", "bytes", "lit px", "us");
+  bench_screen total = { "total", 0, 0, 0, 0, 0 };
+  for (uint8_t i = 0; i < screen_count; i++) {
+    const bench_screen& s = screens[i];
+    printf("%-20s %8.1f %8.1f %8.1f %8.1f %10.2f\n", s.name, (double)s.frames / rounds, (double)s.draw_calls / rounds,
+           (double)s.bytes_sent / rounds, s.frames ? (double)s.lit_pixels / s.frames : 0.0, s.seconds * 1e6 / rounds);
+    total.frames += s.frames;
+    total.draw_calls += s.draw_calls;
+    total.bytes_sent += s.bytes_sent;
+    total.lit_pixels += s.lit_pixels;
+    total.seconds += s.seconds;
+  }
+  printf("%-20s %8.1f %8.1f %8.1f %8.1f %10.2f\n", total.name, (double)total.frames / rounds, (double)total.draw_calls / rounds,
+         (double)total.bytes_sent / rounds, total.frames ? (double)total.lit_pixels / total.frames : 0.0,
+         total.seconds * 1e6 / rounds);
+  return 0;
+}
+
+// Where the catch up results go, volatile so the calls can't be optimised away
+static volatile uint8_t pets_passed;
+
+/**
+ * Catch Up Pass
+ * Host time for rounds of pets_catch_up(), with time moving on by step each round
+ */
+static double catch_up_pass(unsigned long rounds, uint32_t start, uint32_t step) {
+  uint32_t time = start;
+  std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+  for (unsigned long round = 0; round < rounds; round++) {
+    time += step;
+    pets_passed = pets_catch_up(time, pet_none);
+  }
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+  return seconds;
+}
+
+int bench_pets(unsigned long rounds) {
+  printf("pet store: %u bytes for %u pets\n", (unsigned)sizeof(pet_store), pets_max);
+  printf("%-6s %12s %12s\n", "pets", "idle ns", "due ns");
+  for (uint8_t count = 1; count <= pets_max; count++) {
+    const uint32_t start = DateTime().unixtime();
+    pets = pet_store();
+    for (uint8_t slot = 0; slot < count; slot++) {
+      tamagotchi tama;
+      tama.birth = start;
+      tama.ticked = start;
+      pets_put(slot, tama);
+    }
+    rng_seed(count);
+
+    // Nearly every loop() pass: nobody has an interval due. Then every pass a whole interval for everyone.
+    double idle = catch_up_pass(rounds, start, 0);
+    double due = catch_up_pass(rounds, start, tick_interval);
+    printf("%-6u %12.1f %12.1f\n", count, idle * 1e9 / rounds, due * 1e9 / rounds);
+  }
+  return 0;
+}
+
+#endif
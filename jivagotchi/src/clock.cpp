@@ -0,0 +1,42 @@
+/*
+ * Jiva-gotchi: Game Clock
+ * base_time/base_ms is the last RTC reading and when it was taken. latest is the last time handed out,
+ * which is what keeps the clock from stepping back when a resync finds millis() had run fast.
+*/
+
+#include "clock.h"
+
+static const uint32_t resync_ms = JIV_CLOCK_RESYNC_S * 1000UL;
+
+static bool synced = false;
+static uint32_t base_time = 0;
+static uint32_t base_ms = 0;
+static uint32_t latest = 0;
+
+/**
+ * Hand out
+ * Holds the time until the RTC catches up, rather than going backwards
+ */
+static uint32_t hand_out(uint32_t time) {
+  if (synced && (int32_t)(time - latest) < 0) {
+    return latest;
+  }
+  latest = time;
+  return time;
+}
+
+uint32_t clock_sync() {
+  base_time = hal_rtc_now().unixtime();
+  base_ms = hal_millis();
+  uint32_t time = hand_out(base_time);
+  synced = true;
+  return time;
+}
+
+uint32_t clock_now() {
+  uint32_t elapsed = hal_millis() - base_ms;
+  if (!synced || elapsed >= resync_ms) {
+    return clock_sync();
+  }
+  return hand_out(base_time + elapsed / 1000);
+}
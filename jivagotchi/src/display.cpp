@@ -0,0 +1,354 @@
+/*
+ * Jiva-gotchi: Display Scenes
+*/
+
+#include "display.h"
+
+/**
+ * Tile tracking
+ * One bit per 8x8 tile, one 16 bit row per 8 pixel band
+ */
+static const uint8_t tile_rows = 8;
+static uint16_t tiles_drawn[tile_rows];
+
+static frame_stats last_frame = { 0, 0, 0 };
+static frame_stats current_frame = { 0, 0, 0 };
+static display_totals totals = { 0, 0, 0, 0 };
+static uint32_t frame_shown_ms = 0;
+
+/**
+ * Sketch items
+ * A flash string (height == 0) or a flash bitmap at a position
+ */
+struct sketch_item {
+  const void *data;
+  uint8_t x;
+  uint8_t y;
+  uint8_t width;
+  uint8_t height;
+};
+
+static const uint8_t sketch_max = 6;
+static sketch_item sketch[sketch_max];
+static uint8_t sketch_len = 0;
+static uint8_t sketch_batch = 0;
+
+/**
+ * Mark Tiles
+ * Records the tiles covered by a box that was just drawn
+ */
+static void mark(int posx, int posy, int width, int height) {
+  current_frame.draw_calls++;
+  if (width <= 0 || height <= 0) {
+    return;
+  }
+
+  int x0 = (posx < 0) ? 0 : posx / 8;
+  int x1 = (posx + width - 1) / 8;
+  int y0 = (posy < 0) ? 0 : posy / 8;
+  int y1 = (posy + height - 1) / 8;
+  if (x1 > 15) {
+    x1 = 15;
+  }
+  if (y1 > tile_rows - 1) {
+    y1 = tile_rows - 1;
+  }
+
+  uint16_t bits = 0;
+  for (int x = x0; x <= x1; x++) {
+    bits |= (uint16_t)1 << x;
+  }
+  for (int y = y0; y <= y1; y++) {
+    tiles_drawn[y] |= bits;
+  }
+}
+
+/**
+ * Count Lit
+ * Adds up the set pixels in what has been drawn so far. Clearing the lowest set bit once per pixel costs
+ * next to nothing on the sparse screens where it matters.
+ */
+static void count_lit() {
+  uint16_t len;
+  const uint8_t *bytes = hal_display_buffer(len);
+  uint16_t lit = 0;
+  for (uint16_t i = 0; i < len; i++) {
+    for (uint8_t b = bytes[i]; b != 0; b &= b - 1) {
+      lit++;
+    }
+  }
+  current_frame.lit_pixels += lit;
+}
+
+static void end_frame() {
+  frame_shown_ms = hal_millis();
+  totals.frames++;
+  totals.draw_calls += current_frame.draw_calls;
+  totals.bytes_sent += current_frame.bytes_sent;
+  totals.lit_pixels += current_frame.lit_pixels;
+  last_frame = current_frame;
+  current_frame.draw_calls = 0;
+  current_frame.bytes_sent = 0;
+  current_frame.lit_pixels = 0;
+}
+
+#ifdef JIV_PAGE_BUFFER
+
+void render(scene_fn scene, const void *ctx) {
+  hal_display_first_page();
+  do {
+    scene(ctx);
+    count_lit();
+    current_frame.bytes_sent += 128 * JIV_PAGE_BUFFER;
+  } while (hal_display_next_page());
+  end_frame();
+}
+
+void render_over(scene_fn base, const void *base_ctx, scene_fn overlay, const void *overlay_ctx) {
+  hal_display_first_page();
+  do {
+    base(base_ctx);
+    overlay(overlay_ctx);
+    count_lit();
+    current_frame.bytes_sent += 128 * JIV_PAGE_BUFFER;
+  } while (hal_display_next_page());
+  end_frame();
+}
+
+#else
+
+static uint16_t tiles_shown[tile_rows];
+
+/**
+ * Commit
+ * Sends the tiles in dirty[] to the panel as runs along each tile row
+ */
+static void commit(const uint16_t *dirty) {
+  for (uint8_t y = 0; y < tile_rows; y++) {
+    uint8_t x = 0;
+    while (x < 16) {
+      if (!(dirty[y] & ((uint16_t)1 << x))) {
+        x++;
+        continue;
+      }
+      uint8_t start = x;
+      while (x < 16 && (dirty[y] & ((uint16_t)1 << x))) {
+        x++;
+      }
+      hal_display_update_area(start, y, x - start, 1);
+      current_frame.bytes_sent += (x - start) * 8;
+    }
+  }
+}
+
+void render(scene_fn scene, const void *ctx) {
+  // Whatever was on screen has to be flushed too, so that it gets erased
+  for (uint8_t y = 0; y < tile_rows; y++) {
+    tiles_drawn[y] = 0;
+  }
+  hal_display_clear_buffer();
+  scene(ctx);
+
+  uint16_t dirty[tile_rows];
+  for (uint8_t y = 0; y < tile_rows; y++) {
+    dirty[y] = tiles_drawn[y] | tiles_shown[y];
+    tiles_shown[y] = tiles_drawn[y];
+  }
+  count_lit();
+  commit(dirty);
+  end_frame();
+}
+
+void render_over(scene_fn base, const void *base_ctx, scene_fn overlay, const void *overlay_ctx) {
+  (void)base;
+  (void)base_ctx;
+  for (uint8_t y = 0; y < tile_rows; y++) {
+    tiles_drawn[y] = 0;
+  }
+  overlay(overlay_ctx);
+  // The buffer still holds the base scene, so this is the whole screen
+  count_lit();
+
+  commit(tiles_drawn);
+  for (uint8_t y = 0; y < tile_rows; y++) {
+    tiles_shown[y] |= tiles_drawn[y];
+  }
+  end_frame();
+}
+
+#endif
+
+/**
+ * Drawing
+ */
+
+void draw_text(int posx, int posy, const char *text) {
+  hal_display_text(posx, posy, text);
+  mark(posx, posy - hal_display_ascent(), hal_display_text_width(text), hal_display_ascent() + hal_display_descent());
+}
+
+void draw_text(int posx, int posy, const __FlashStringHelper *text) {
+  hal_display_text(posx, posy, text);
+  mark(posx, posy - hal_display_ascent(), hal_display_text_width(text), hal_display_ascent() + hal_display_descent());
+}
+
+void draw_number(int posx, int posy, const __FlashStringHelper *label, uint16_t value, char suffix) {
+  char text[16 + number_text_max + 2];
+  char *out = text;
+  if (label != NULL) {
+    uint8_t len = strlen_P((const char *)label);
+    if (len > 16) {
+      len = 16;
+    }
+    memcpy_P(out, label, len);
+    out += len;
+  }
+  out = number_text(out, value);
+  if (suffix != 0) {
+    *out++ = suffix;
+  }
+  *out = '\0';
+  draw_text(posx, posy, text);
+}
+
+char *number_text(char *out, uint16_t value) {
+  static const uint16_t powers[number_text_max - 1] = {10000, 1000, 100, 10};
+  bool leading = true;
+  for (uint8_t i = 0; i < number_text_max - 1; i++) {
+    char digit = '0';
+    while (value >= powers[i]) {
+      value -= powers[i];
+      digit++;
+    }
+    if (digit != '0' || !leading) {
+      *out++ = digit;
+      leading = false;
+    }
+  }
+  *out++ = '0' + value;
+  return out;
+}
+
+void draw_bitmap(int posx, int posy, int width, int height, const unsigned char *pic) {
+  hal_display_bitmap(posx, posy, width, height, pic);
+  mark(posx, posy, width, height);
+}
+
+void draw_bitmap_ram(int posx, int posy, int width, int height, const unsigned char *pic) {
+  hal_display_bitmap_ram(posx, posy, width, height, pic);
+  mark(posx, posy, width, height);
+}
+
+/**
+ * Frame Stats
+ */
+
+const frame_stats& display_last_frame() {
+  return last_frame;
+}
+
+uint32_t display_total_bytes() {
+  return totals.bytes_sent;
+}
+
+const display_totals& display_total() {
+  return totals;
+}
+
+uint32_t frame_pace(uint32_t ms) {
+  if (ms < frame_min_ms) {
+    ms = frame_min_ms;
+  }
+  uint32_t shown_for = hal_millis() - frame_shown_ms;
+  return (shown_for < ms) ? ms - shown_for : 0;
+}
+
+/**
+ * Sketch Scene
+ * Draws the items collected by printImage and print_f_text
+ */
+static void scene_sketch(const void *ctx) {
+  (void)ctx;
+  for (uint8_t i = 0; i < sketch_len; i++) {
+    const sketch_item& item = sketch[i];
+    if (item.height == 0) {
+      draw_text(item.x, item.y, (const __FlashStringHelper *)item.data);
+    } else {
+      draw_bitmap(item.x, item.y, item.width, item.height, (const unsigned char *)item.data);
+    }
+  }
+}
+
+/**
+ * Add to Sketch
+ * Appends an item and redraws, unless a frame is being batched; items past sketch_max are dropped
+ */
+static void sketch_add(const void *data, bool clear, int posx, int posy, int width, int height) {
+  if (clear) {
+    sketch_len = 0;
+  }
+  if (sketch_len < sketch_max) {
+    sketch[sketch_len].data = data;
+    sketch[sketch_len].x = posx;
+    sketch[sketch_len].y = posy;
+    sketch[sketch_len].width = width;
+    sketch[sketch_len].height = height;
+    sketch_len++;
+  }
+  if (sketch_batch == 0) {
+    render(scene_sketch);
+  }
+}
+
+/**
+ * Frame Begin/Commit
+ * Batch a run of sketch calls into a single frame, may be nested
+ */
+void frame_begin() {
+  sketch_batch++;
+}
+
+void frame_commit() {
+  if (sketch_batch > 0 && --sketch_batch == 0) {
+    render(scene_sketch);
+  }
+}
+
+/**
+ * Clear Screen
+ * Clears the OLED screen so that a new frame can be shown
+ */
+void clearScreen() {
+  sketch_len = 0;
+  if (sketch_batch == 0) {
+    render(scene_sketch);
+  }
+}
+
+/**
+ * Print Image
+ * Prints a bitmap image from flash memory
+ * 
+ * @param   width   The height of the image
+ * @param   height  The width of the image
+ * @param   pic     A PROGMEM variable containing the bitmap of the image
+ * @param   clear   OPTIONAL - A boolean, true to clear the screen false to keep it (Default: True)
+ * @param   posx    OPTIONAL - X Position of the image to be drawn (Default: 0)
+ * @param   posy    OPTIONAL - Y Position of the image to be drawn (Default: 0)
+ */
+void printImage(int width, int height, const unsigned char *pic, bool clear, int posx, int posy) {
+  sketch_add(pic, clear, posx, posy, width, height);
+}
+
+/**
+ * Print F() Style Text
+ * Because SRAM is a valuable resource
+ * 
+ * @param   text    The F() string
+ * @param   clear   Whether or not to clear the screen before printing
+ * @param   posx    X Position for printing
+ * @param   posy    Y Position for printing
+ */
+void print_f_text(const __FlashStringHelper* text, bool clear, int posx, int posy) {
+  sketch_add(text, clear, posx, posy, 0, 0);
+}
@@ -0,0 +1,921 @@
+/*
+ * Jiva-gotchi: Game Core
+ * Written By: Jivan RamjiSingh
+ * 2022-01-23
+ * Licensed under GPL v3.0
+*/
+
+#include "game.h"
+#include "display.h"
+#include "sprite.h"
+#include "scheduler.h"
+#include "clock.h"
+#include "telemetry.h"
+#include "rng.h"
+#include "pets.h"
+#include "power.h"
+
+/**
+ * Global Variables
+ */
+uint32_t now, last_action;
+tamagotchi jiv;
+bool changed = true;
+bool night_sleep = false;
+bool sleep_tama = false;
+sleep_report last_sleep;
+
+/**
+ * Function definitions
+ */
+
+/**
+ * Home Scene
+ * Tama stats and status faces
+ *
+ * @param   ctx     The tamagotchi
+ */
+static void scene_home(const void *ctx) {
+  const tamagotchi& tama = *(const tamagotchi *)ctx;
+
+  draw_number(0, 35, F("Happy: "), tama.happy, '%');
+  draw_number(0, 45, F("Hunger: "), tama.hunger, '%');
+  draw_number(0, 55, F("Discipline: "), tama.discipline, '%');
+  draw_number(20, 20, NULL, tama.level);
+
+  if (!tama.health) {
+    draw_text(30, 20, F(":("));
+  } 
+  
+  if (tama.soiled) {
+    draw_text(45, 20, F("O.o"));
+  }
+  
+  if (tama.misbehave) {
+    draw_text(70, 20, F(">:)"));
+  }
+}
+
+/**
+ * Sprite Scene
+ * An idle frame in the top left corner
+ *
+ * @param   ctx     A sprite_view
+ */
+struct sprite_view {
+  uint8_t level;
+  uint8_t frame;
+};
+
+static void scene_sprite(const void *ctx) {
+  const sprite_view *view = (const sprite_view *)ctx;
+  draw_sprite(0, 0, view->level, view->frame);
+}
+
+/**
+ * Print Tama Stats
+ * Displays tama data on the screen
+ * 
+ * @param   tama    Tamagotchi object containing requested data
+ */
+void print_stats(tamagotchi& tama) {
+  render(scene_home, &tama);
+}
+
+/**
+ * Processes the "life functions" of the tamagotchi (getting hungry, bored, bathroom, etc.)
+ * This function lowers those values to facilitate gameplay
+ * 
+ * @param   tama    The tamagotchi object to be processed
+ */
+void passTime(tamagotchi& tama) {
+  if (tama.soiled) {
+    // if tama pooped, make it sick 50% of the time
+    if (rng_below(100) > 50) {
+      tama.health = false;
+    }
+  } else {
+    // otherwise make it poop, 25% of the time
+    if (rng_below(100) > 75) {
+      tama.soiled = true;
+    }
+  }
+
+  if ((tama.happy <= 0) || (tama.hunger <= 0) || (tama.snacks_fed > 5)) {
+    // Make tama sick if its happiness or hunger is 0, or if it ate too many snacks
+    tama.health = false;
+  } else if (tama.discipline == 0) {
+    // Misbehave when undisciplined. This used to be random(discipline) == discipline, which can
+    // only come true for random(0), so it never depended on how much discipline there was
+    tama.misbehave = true;
+  } else {
+    stat_add(tama.happy, -5);
+    stat_add(tama.hunger, -5);
+  }
+}
+
+/**
+ * Fixed point probabilities
+ * Q16 chances of passTime() leaving the tama alone: rng_below(100) > 75 poops, rng_below(100) > 50 makes
+ * a soiled tama sick
+ */
+static const uint32_t q16_one = 65536;
+static const uint32_t q16_stays_clean = 49807;    // 76/100
+static const uint32_t q16_stays_healthy = 33423;  // 51/100
+
+/**
+ * Pass Times
+ * Same outcome, in distribution, as calling passTime() intervals times, in a handful of random draws.
+ * Nothing passTime() does changes discipline or snacks_fed, so:
+ * - a clean tama poops after a geometric number of intervals, and a soiled one stays soiled
+ * - each soiled interval after that makes it sick with 49/100, so it stays healthy with 0.51^n
+ * - the stat branch is deterministic: too many snacks always sickens, zero discipline always misbehaves,
+ *   otherwise happy and hunger drop by 5 until one of them is 0 and the next interval sickens
+ *
+ * @param   tama        The tamagotchi object to be processed
+ * @param   intervals   How many 30 minute intervals passed
+ */
+void passTimes(tamagotchi& tama, uint32_t intervals) {
+  if (intervals == 0) {
+    return;
+  }
+  if (intervals == 1) {
+    passTime(tama);
+    return;
+  }
+
+  // P(still clean after k intervals) = 0.76^k, stopping at the first k where that falls to u or below
+  uint32_t soiled_intervals = intervals;
+  if (!tama.soiled) {
+    uint32_t u = rng_u16();
+    uint32_t clean = q16_one;
+    soiled_intervals = 0;
+    for (uint32_t k = 1; k <= intervals; k++) {
+      clean = (clean * q16_stays_clean) >> 16;
+      if (u >= clean) {
+        tama.soiled = true;
+        soiled_intervals = intervals - k;
+        break;
+      }
+    }
+  }
+
+  if (soiled_intervals > 0) {
+    uint32_t u = rng_u16();
+    uint32_t healthy = q16_one;
+    for (uint32_t k = 0; k < soiled_intervals && healthy > u; k++) {
+      healthy = (healthy * q16_stays_healthy) >> 16;
+    }
+    if (u >= healthy) {
+      tama.health = false;
+    }
+  }
+
+  if (tama.snacks_fed > 5) {
+    tama.health = false;
+  } else if (tama.discipline == 0) {
+    // An undisciplined tama misbehaves instead of getting hungry
+    if ((tama.happy == 0) || (tama.hunger == 0)) {
+      tama.health = false;
+    } else {
+      tama.misbehave = true;
+    }
+  } else {
+    uint8_t lowest = (tama.happy < tama.hunger) ? tama.happy : tama.hunger;
+    uint32_t drops = (lowest + 4) / 5;
+    if (intervals > drops) {
+      tama.health = false;
+    } else {
+      drops = intervals;
+    }
+    stat_add(tama.happy, -5 * (int)drops);
+    stat_add(tama.hunger, -5 * (int)drops);
+  }
+}
+
+bool catchUp(tamagotchi& tama, uint32_t time) {
+  if ((int32_t)(time - tama.ticked) < (int32_t)tick_interval) {
+    return false;
+  }
+  uint32_t intervals = (time - tama.ticked) / tick_interval;
+  passTimes(tama, intervals);
+  tama.ticked += intervals * tick_interval;
+  return true;
+}
+
+/**
+ * Level ages
+ * How long after the last level up (tama.birth) the next one becomes due: 5 hours, 1 day, 2 days
+ */
+static const uint32_t level_up_age[level_max - 1] = {18000, 86400, 172800};
+
+bool good_standing(const tamagotchi& tama) {
+  return !tama.soiled && tama.health && !tama.misbehave && (tama.hunger > 75) && (tama.happy > 75);
+}
+
+bool level_up_due(const tamagotchi& tama, uint32_t time) {
+  return (tama.level < level_max) && ((time - tama.birth) > level_up_age[tama.level - 1]) && good_standing(tama);
+}
+
+void care_level_up(tamagotchi& tama, uint32_t time) {
+  stat_add(tama.level, 1, level_max);
+  tama.birth = time;
+}
+
+void care_over_under(tamagotchi& tama) {
+  stat_add(tama.happy, 10);
+}
+
+void care_right_left(tamagotchi& tama) {
+  stat_add(tama.happy, 5);
+}
+
+bool care_heal(tamagotchi& tama) {
+  if (tama.health) {
+    stat_add(tama.happy, -10);
+    return false;
+  }
+  tama.health = true;
+  return true;
+}
+
+bool care_scold(tamagotchi& tama) {
+  if (!tama.misbehave) {
+    stat_add(tama.happy, -20);
+    return false;
+  }
+  stat_add(tama.discipline, 25);
+  stat_add(tama.happy, -5);
+  tama.misbehave = false;
+  return true;
+}
+
+bool care_clean(tamagotchi& tama) {
+  if (!tama.soiled) {
+    return false;
+  }
+  stat_add(tama.happy, 20);
+  tama.soiled = false;
+  return true;
+}
+
+bool care_meal(tamagotchi& tama) {
+  if (tama.misbehave) {
+    return false;
+  }
+  stat_add(tama.hunger, 20);
+  tama.snacks_fed = 0;
+  return true;
+}
+
+bool care_snack(tamagotchi& tama) {
+  if (tama.misbehave) {
+    return false;
+  }
+  stat_add(tama.hunger, 10);
+  stat_add(tama.snacks_fed, 1, 255);
+  stat_add(tama.happy, 10);
+  return true;
+}
+
+uint32_t night_morning(const tamagotchi& tama) {
+  // 9 hours, 32400 seconds
+  return tama.ticked + 32400 + 1;
+}
+
+void night_over(tamagotchi& tama, uint32_t morning) {
+  // The night doesn't count, but like before one interval is due straight away
+  tama.ticked = morning - 1 - tick_interval;
+}
+
+/**
+ * Over Under Scene
+ * The first number and the guess prompt, or both numbers and the verdict once it's revealed
+ *
+ * @param   ctx     An over_under_view
+ */
+struct over_under_view {
+  uint8_t first;
+  uint8_t second;
+  int8_t guess;
+  const __FlashStringHelper *verdict;
+  bool closing;
+};
+
+static void scene_over_under(const void *ctx) {
+  const over_under_view *view = (const over_under_view *)ctx;
+
+  draw_number(0, 10, NULL, view->first);
+
+  if (view->verdict == NULL) {
+    draw_text(0, 20, F("Up A"));
+    draw_text(0, 30, F("Low B"));
+    draw_text(0, 40, F("Confirm C"));
+    if (view->guess == 1) {
+      draw_text(0, 50, F("GUESS: OVER"));
+    } else if (view->guess == 0) {
+      draw_text(0, 50, F("GUESS: UNDER"));
+    }
+  } else {
+    draw_number(0, 20, NULL, view->second);
+    draw_text(0, 30, view->verdict);
+    if (view->closing) {
+      draw_text(0, 50, F("C to close."));
+    }
+  }
+}
+
+/**
+ * Action steps
+ * Every action below is a state machine run by the scheduler (scheduler.h). The tama is the action's ctx,
+ * and each step ends by saying what it waits for next.
+ */
+
+/**
+ * Tamagotchi Game: Over Under
+ * Guessing whether the second of two random numbers between 1 - 10 will be higher or lower than the first
+ * Playing the game will increase the happiness level of the tamagotchi
+ * 
+ * TODO: Game splash screen?
+ * 
+ * @param   act     The running action, ctx is the tamagotchi object to be processed
+ */
+static over_under_view over_under;
+
+void overUnder(action& act) {
+  tamagotchi& tama = *(tamagotchi *)act.ctx;
+
+  switch (act.step) {
+    case 0:
+      // Set up the game
+      over_under.first = rng_range(1, 11);
+      over_under.second = rng_range(1, 11);
+      over_under.guess = -1;
+      over_under.verdict = NULL;
+      over_under.closing = false;
+      render(scene_over_under, &over_under);
+      action_wait(act, 0, 1);
+      break;
+
+    case 1:
+      // Prompt for input, only redrawing when the guess changes
+      switch (input_next_press()) {
+        case buttonC:
+          act.step = 2;
+          break;
+        case buttonA:
+          if (over_under.guess != 1) {
+            over_under.guess = 1;
+            render(scene_over_under, &over_under);
+          }
+          break;
+        case buttonB:
+          if (over_under.guess != 0) {
+            over_under.guess = 0;
+            render(scene_over_under, &over_under);
+          }
+          break;
+        default:
+          action_wait(act, button_poll_ms, 1);
+          break;
+      }
+      break;
+
+    case 2: {
+      // Evaluate and display results
+      bool user_guess = (over_under.guess == 1);
+      if (((over_under.first < over_under.second) && user_guess) || ((over_under.first > over_under.second && !user_guess))) {
+        over_under.verdict = F("POGCHAMP");
+      } else if (over_under.first == over_under.second) {
+        over_under.verdict = F("...no comment...");
+      } else {
+        over_under.verdict = F("Sadge");
+      }
+      render(scene_over_under, &over_under);
+      action_wait(act, 500, 3);
+      break;
+    }
+
+    case 3:
+      // Set tama happiness level
+      care_over_under(tama);
+      changed = true;
+      over_under.closing = true;
+      render(scene_over_under, &over_under);
+      action_wait_button(act, buttonC, 4);
+      break;
+
+    default:
+      action_done(act);
+      break;
+  }
+}
+
+/**
+ * Right Left Scene
+ * The guess prompt, or the tama facing its chosen side and the verdict
+ *
+ * @param   ctx     A right_left_view
+ */
+struct right_left_view {
+  int8_t guess;
+  uint8_t level;
+  int sprite_x;
+  const __FlashStringHelper *verdict;
+};
+
+static void scene_right_left(const void *ctx) {
+  const right_left_view *view = (const right_left_view *)ctx;
+
+  if (view->verdict == NULL) {
+    draw_text(0, 10, F("Left A"));
+    draw_text(0, 20, F("Right B"));
+    draw_text(0, 30, F("Confirm C"));
+    if (view->guess == 1) {
+      draw_text(0, 50, F("GUESS: LEFT"));
+    } else if (view->guess == 0) {
+      draw_text(0, 50, F("GUESS: RIGHT"));
+    }
+  } else {
+    draw_sprite(view->sprite_x, 0, view->level, 0);
+    draw_text(0, 35, view->verdict);
+    draw_text(0, 50, F("C to close."));
+  }
+}
+
+/**
+ * Tamagotchi Game: Left Right
+ * Guessing whether the tamagotchi will turn to the left or the right
+ * Playing the game will increase the happiness level of the tamagotchi
+ * 
+ * TODO: Game splash screen?
+ * 
+ * @param   act     The running action, ctx is the tamagotchi object to be processed
+ */
+static right_left_view right_left;
+static bool right_left_direction;
+
+void rightLeft(action& act) {
+  tamagotchi& tama = *(tamagotchi *)act.ctx;
+
+  switch (act.step) {
+    case 0:
+      // Set up the game
+      right_left_direction = rng_below(2);
+      right_left.guess = -1;
+      right_left.level = tama.level;
+      right_left.sprite_x = 0;
+      right_left.verdict = NULL;
+      render(scene_right_left, &right_left);
+      action_wait(act, 0, 1);
+      break;
+
+    case 1:
+      // Prompt user for input, only redrawing when the guess changes
+      switch (input_next_press()) {
+        case buttonC:
+          act.step = 2;
+          break;
+        case buttonA:
+          if (right_left.guess != 1) {
+            right_left.guess = 1;
+            render(scene_right_left, &right_left);
+          }
+          break;
+        case buttonB:
+          if (right_left.guess != 0) {
+            right_left.guess = 0;
+            render(scene_right_left, &right_left);
+          }
+          break;
+        default:
+          action_wait(act, button_poll_ms, 1);
+          break;
+      }
+      break;
+
+    case 2: {
+      // left or right
+      right_left.sprite_x = right_left_direction ? 90 : 0;
+
+      // Evaluate results
+      bool user_guess = (right_left.guess == 1);
+      if (right_left_direction == user_guess ) {
+        right_left.verdict = F("POGCHAMP");
+      } else {
+        right_left.verdict = F("Sadge");
+      }
+
+      care_right_left(tama);
+      changed = true;
+      render(scene_right_left, &right_left);
+      action_wait_button(act, buttonC, 3);
+      break;
+    }
+
+    default:
+      action_done(act);
+      break;
+  }
+}
+
+/**
+ * Continue Prompt
+ * The tail every care action ends with: flag the stats for a redraw, pause, then wait for C
+ * Uses steps 100 - 102 of the calling action
+ *
+ * @param   act     The running action
+ * @param   posy    Where the prompt goes
+ */
+static const uint8_t step_continue = 100;
+
+static void continue_prompt(action& act, int posy) {
+  switch (act.step) {
+    case step_continue:
+      changed = true;
+      action_wait(act, 300, step_continue + 1);
+      break;
+
+    case step_continue + 1:
+      print_f_text(F("C to continue"), false, 0, posy);
+      action_wait_button(act, buttonC, step_continue + 2);
+      break;
+
+    default:
+      action_done(act);
+      break;
+  }
+}
+
+/**
+ * Healing the sickness of a tamagotchi
+ * When a tamagotchi is sick, they will need to be given "medicine" to become healthy again
+ * 
+ * @param   act     The running action, ctx is the tamagotchi object to be processed
+ */
+void heal(action& act) {
+  tamagotchi& tama = *(tamagotchi *)act.ctx;
+
+  switch (act.step) {
+    case 0:
+      if (care_heal(tama)) {
+        print_f_text(F("Healing..."), true, 10, 40);
+        action_wait(act, 4000, 1);
+      } else {
+        print_f_text(F("Jiv is not sick!"), true, 10, 40);
+        action_wait(act, 2000, step_continue);
+      }
+      break;
+
+    case 1:
+      print_f_text(F("Healed!"), true, 10, 40);
+      action_wait(act, 1000, step_continue);
+      break;
+
+    default:
+      continue_prompt(act, 60);
+      break;
+  }
+}
+
+/**
+ * Discipling the tamagotchi
+ * When a tamagotchi is misbehaving, they will need to be disciplined 
+ * Doing so increases the discipline meter
+ * 
+ * @param   act     The running action, ctx is the tamagotchi object to be processed
+ */
+void scold(action& act) {
+  tamagotchi& tama = *(tamagotchi *)act.ctx;
+
+  switch (act.step) {
+    case 0:
+      if (care_scold(tama)) {
+        print_f_text(F("Scolding..."), true, 10, 40);
+        action_wait(act, 4000, 1);
+      } else {
+        print_f_text(F("Jiv isn't misbehaving"), true, 0, 30);
+        action_wait(act, 1000, 2);
+      }
+      break;
+
+    case 1:
+      print_f_text(F("Scolded!"), true, 10, 40);
+      action_wait(act, 1000, step_continue);
+      break;
+
+    case 2:
+      print_f_text(F("... :( ..."), false, 20, 40);
+      act.step = step_continue;
+      break;
+
+    default:
+      continue_prompt(act, 60);
+      break;
+  }
+}
+
+/**
+ * Cleaning excrement
+ * When a tamagotchi poops, someone has to be the shit scraper
+ * 
+ * @param   act     The running action, ctx is the tamagotchi object to be processed
+ */
+void clean(action& act) {
+  tamagotchi& tama = *(tamagotchi *)act.ctx;
+
+  switch (act.step) {
+    case 0:
+      if (care_clean(tama)) {
+        print_f_text(F("Cleaning..."), true, 10, 40);
+        action_wait(act, 2000, 1);
+      } else {
+        print_f_text(F("Jiv didn't poo!"), true, 0, 30);
+        act.step = step_continue;
+      }
+      break;
+
+    case 1:
+      print_f_text(F("Cleaned!"), true, 10, 40);
+      act.step = step_continue;
+      break;
+
+    default:
+      continue_prompt(act, 60);
+      break;
+  }
+}
+
+/**
+ * Feed Tamagotchi
+ * Player can either feed tamagotchi snack or meal
+ * Misbehaving tamagotchis will refuse to eat
+ * 
+ * @param   act     The running action, ctx is the tamagotchi object to be fed
+ */
+void feed(action& act) {
+  tamagotchi& tama = *(tamagotchi *)act.ctx;
+
+  switch (act.step) {
+    case 0:
+      if (tama.misbehave) {
+        print_f_text(F("Jiv refuses to eat!"), true, 10, 10);
+        act.step = step_continue;
+      } else {
+        frame_begin();
+        print_f_text(F("Feed Jiv:"), true, 10, 20);
+        print_f_text(F("A: Meal"), false, 10, 30);
+        print_f_text(F("B: Snack"), false, 10, 40);
+        frame_commit();
+        action_wait(act, 0, 1);
+      }
+      break;
+
+    case 1:
+      switch (input_next_press()) {
+        case buttonC:
+          act.step = step_continue;
+          break;
+        case buttonA:
+          if (care_meal(tama)) {
+            print_f_text(F("Jiv Fed!"), true, 10, 10);
+          } else {
+            print_f_text(F("Jiv refuses to eat!"), true, 10, 10);
+          }
+          act.step = step_continue;
+          break;
+        case buttonB:
+          if (care_snack(tama)) {
+            print_f_text(F("Jiv Fed"), true, 20, 10);
+          } else {
+            print_f_text(F("Jiv refuses to eat!"), true, 10, 10);
+          }
+          act.step = step_continue;
+          break;
+        default:
+          action_wait(act, button_poll_ms, 1);
+          break;
+      }
+      break;
+
+    default:
+      continue_prompt(act, 50);
+      break;
+  }
+}
+
+/**
+ * Level Up
+ * Tamagotchi can only be levelled up when they are in good standing
+ * Not soiled, healthy, behaving, >75% hungry, >75% happy
+ * 
+ * @param   act     The running action, ctx is the tamagotchi object to be levelled up
+ */
+void level_up(action& act) {
+  tamagotchi& tama = *(tamagotchi *)act.ctx;
+
+  switch (act.step) {
+    case 0:
+      if (good_standing(tama)) {
+        print_f_text(F("Leveling up....."), true, 20, 40);
+        action_wait(act, 2000, 1);
+      } else {
+        frame_begin();
+        print_f_text(F("Jiv is not able to be"), true, 0, 30);
+        print_f_text(F("leveled up :("), false, 20, 40);
+        print_f_text(F("C to continue"), 0, 50);
+        frame_commit();
+        action_wait_button(act, buttonC, 2);
+      }
+      break;
+
+    case 1:
+      frame_begin();
+      print_f_text(F("Leveled Up!"), true, 20, 40);
+      care_level_up(tama, clock_now());
+      changed = true;
+      save_soon();
+      telemetry_event(event_level_up, tama.level);
+      print_f_text(F("C to continue"), 0, 50);
+      frame_commit();
+      action_wait_button(act, buttonC, 2);
+      break;
+
+    default:
+      action_done(act);
+      break;
+  }
+}
+
+/**
+ * Idle Animations
+ * Make the tama do a lil dance in the corner lol
+ * Redraws the stats first if anything changed since the last dance
+ * 
+ * @param   act     The running action, ctx is the tamagotchi to make dance
+ */
+void idle_ani(action& act) {
+  tamagotchi& tama = *(tamagotchi *)act.ctx;
+  static sprite_view view;
+
+  if (act.step == 0) {
+    if (changed) {
+      print_stats(tama);
+      changed = false;
+      telemetry_state(tama);
+    }
+    view.level = tama.level;
+  }
+
+  if (act.step >= idle_frames) {
+    action_done(act);
+    return;
+  }
+
+  // Only the sprite changes between frames, so it goes over whatever the home scene left on screen
+  view.frame = act.step;
+  render_over(scene_home, &tama, scene_sprite, &view);
+  action_wait(act, frame_pace(sprite_frame_ms(view.level, view.frame)), act.step + 1);
+}
+
+/**
+ * Glance
+ * Stands in for the idle animation once the screen has dimmed all the way (power.h): the level, and a
+ * mark if the pet is sick, soiled or misbehaving. Redrawn every second, which sends only the tiles it
+ * covers. Ends when there is activity again, and the home screen is drawn afresh.
+ *
+ * @param   act     The running action, ctx is the tamagotchi
+ */
+static void scene_glance(const void *ctx) {
+  const tamagotchi& tama = *(const tamagotchi *)ctx;
+
+  draw_number(20, 20, NULL, tama.level);
+  if (!tama.health || tama.soiled || tama.misbehave) {
+    draw_text(30, 20, F("!"));
+  }
+}
+
+void glance(action& act) {
+  if (power_stage() != power_glance) {
+    changed = true;
+    action_done(act);
+    return;
+  }
+  render(scene_glance, act.ctx);
+  action_wait(act, 1000, 1);
+}
+
+/**
+ * Tuck In
+ * Puts the tama to bed for the night; loop() starts the sleep on its next pass
+ *
+ * @param   act     The running action
+ */
+void tuck_in(action& act) {
+  sleep_tama = true;
+  night_sleep = true;
+  action_done(act);
+}
+
+/**
+ * Pet Scene
+ * Which slot the pet on screen is in, next to its sprite
+ *
+ * @param   ctx     The tamagotchi
+ */
+static void scene_pet(const void *ctx) {
+  const tamagotchi& tama = *(const tamagotchi *)ctx;
+  draw_sprite(0, 0, tama.level, 0);
+  draw_number(40, 30, F("Pet "), active_pet + 1);
+}
+
+/**
+ * Next Pet
+ * Puts the pet on screen away and brings out the one in the next slot, hatching a new one if the slot is
+ * empty. Nothing is written here: the outgoing pet goes back to the store marked dirty, and save_tick()
+ * writes it out a byte a pass like any other pet. The incoming one only needs a checkpoint if it is new or
+ * time passed for it in the store.
+ *
+ * @param   act     The running action, ctx is the tamagotchi on screen
+ */
+void next_pet(action& act) {
+  tamagotchi& tama = *(tamagotchi *)act.ctx;
+
+  if (act.step == 0) {
+    pets_put(active_pet, tama);
+    pets.dirty |= 1 << active_pet;
+    active_pet = (active_pet + 1) % pets_max;
+    bool behind = (pets.dirty & (1 << active_pet)) != 0;
+    if (!pets_get(active_pet, tama)) {
+      tama = tamagotchi();
+      tama.birth = clock_now();
+      tama.ticked = tama.birth;
+      pets_put(active_pet, tama);
+      behind = true;
+    }
+    save_switched(tama, behind);
+    pets.dirty &= ~(1 << active_pet);
+    changed = true;
+    render(scene_pet, &tama);
+    action_wait(act, 1000, 1);
+  } else {
+    clearScreen();
+    action_done(act);
+  }
+}
+
+/**
+ * Sleep Function
+ * Puts the arduino into low power mode, so that a potential connected battery doesn't get drained
+ * Time passed while asleep is caught up all at once by loop() on wake, so the only thing that can be due
+ * is the end of the night. A nap sleeps with the watchdog off until the button. The night counts watchdog
+ * periods instead of reading the RTC on every one: it sleeps through 90% of what's left by the count,
+ * then checks the RTC, which makes up for the watchdog running up to 10% fast or slow.
+ */
+void doSleep(tamagotchi& tama) {
+  save_now(tama);
+  save_pets();
+  uint32_t i2c_start = hal_i2c_count();
+  last_sleep.wakes = 0;
+  telemetry_event(event_sleep, night_sleep);
+  hal_display_power_save(true);
+  hal_sleep_begin();
+
+  bool woken = false;
+  if (!night_sleep) {
+    last_sleep.wakes++;
+    woken = hal_sleep_wait(false);
+  } else {
+    // Sleep through the night
+    uint32_t morning = night_morning(tama);
+    while (!woken) {
+      // millis() stood still while powered down, only the RTC knows how long that was
+      int32_t left = morning - clock_sync();
+      if (left <= 0) {
+        break;
+      }
+      uint32_t periods = (uint32_t)left * 9 / 10 / hal_sleep_period_s + 1;
+      while (periods-- > 0 && !woken) {
+        last_sleep.wakes++;
+        woken = hal_sleep_wait(true);
+      }
+    }
+    if (!woken) {
+      night_over(tama, morning);
+      night_sleep = false;
+    }
+  }
+  sleep_tama = false;
+  now = clock_sync();
+  last_action = now;
+
+  hal_sleep_end();
+  hal_display_power_save(false);
+  last_sleep.i2c = hal_i2c_count() - i2c_start;
+  telemetry_event(event_wake, woken);
+  telemetry_sleep(last_sleep);
+  // Whatever was dropped for sleep (the glance screen, a menu) is still on the panel, the stats go back over it
+  changed = true;
+  // The press that woke us isn't meant for whatever comes up next
+  input_flush();
+}
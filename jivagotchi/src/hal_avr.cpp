@@ -0,0 +1,502 @@
+/*
+ * Jiva-gotchi: Arduino Uno Backend
+ * SH1106 OLED over I2C, DS1307 RTC, three buttons, on-chip EEPROM
+ * The I2C bus goes through Wire, or with -D JIV_TWI_ASYNC=1 through the interrupt driven engine in twi.h
+*/
+
+#ifdef ARDUINO
+
+#include "hal.h"
+#include "input.h"
+#include <avr/sleep.h>
+#include <avr/wdt.h>
+#include <U8g2lib.h>
+#include "font.h"
+#include "twi.h"
+#include <EEPROM.h>
+
+#if JIV_TWI_ASYNC
+
+/**
+ * u8x8 callbacks
+ * Everything u8x8 sends goes out as engine messages. There's no reset pin, so the only GPIO work is the
+ * init sequence's delays, which have to come after the commands before them are actually sent.
+ */
+static uint8_t u8x8_byte_twi(u8x8_t *u8x8, uint8_t msg, uint8_t arg_int, void *arg_ptr) {
+  switch (msg) {
+    case U8X8_MSG_BYTE_START_TRANSFER:
+      twi_message_begin(u8x8_GetI2CAddress(u8x8) >> 1);
+      break;
+    case U8X8_MSG_BYTE_SEND:
+      twi_message_add((const uint8_t *)arg_ptr, arg_int);
+      break;
+    case U8X8_MSG_BYTE_END_TRANSFER:
+      twi_message_end();
+      break;
+    case U8X8_MSG_BYTE_INIT:
+    case U8X8_MSG_BYTE_SET_DC:
+      break;
+    default:
+      return 0;
+  }
+  return 1;
+}
+
+static uint8_t u8x8_gpio_twi(u8x8_t *u8x8, uint8_t msg, uint8_t arg_int, void *arg_ptr) {
+  if (msg == U8X8_MSG_DELAY_MILLI) {
+    twi_wait();
+    delay(arg_int);
+  }
+  return 1;
+}
+
+class sh1106_twi : public U8G2 {
+  public:
+    sh1106_twi() {
+#if JIV_PAGE_BUFFER == 1
+      u8g2_Setup_sh1106_i2c_128x64_noname_1(&u8g2, U8G2_R0, u8x8_byte_twi, u8x8_gpio_twi);
+#elif JIV_PAGE_BUFFER == 2
+      u8g2_Setup_sh1106_i2c_128x64_noname_2(&u8g2, U8G2_R0, u8x8_byte_twi, u8x8_gpio_twi);
+#else
+      u8g2_Setup_sh1106_i2c_128x64_noname_f(&u8g2, U8G2_R0, u8x8_byte_twi, u8x8_gpio_twi);
+#endif
+    }
+};
+sh1106_twi u8g2;
+
+/**
+ * DS1307
+ * Seconds to year in BCD from register 0, the same registers RTClib reads
+ */
+static const uint8_t rtc_address = 0x68;
+
+static uint8_t bcd(uint8_t value) {
+  return value - 6 * (value >> 4);
+}
+
+static const uint8_t rtc_nvram = 0x08;
+
+static bool rtc_begin() {
+  uint8_t seconds;
+  return twi_read(rtc_address, 0, &seconds, 1, twi_standard_hz);
+}
+
+static void rtc_read_nvram(uint8_t address, uint8_t *data, uint8_t len) {
+  twi_read(rtc_address, rtc_nvram + address, data, len, twi_standard_hz);
+}
+
+static void rtc_write_nvram(uint8_t address, const uint8_t *data, uint8_t len) {
+  twi_write(rtc_address, rtc_nvram + address, data, len, twi_standard_hz);
+}
+
+static DateTime rtc_now() {
+  uint8_t regs[7] = { 0 };
+  twi_read(rtc_address, 0, regs, sizeof(regs), twi_standard_hz);
+  return DateTime(2000 + bcd(regs[6]), bcd(regs[5]), bcd(regs[4]), bcd(regs[2] & 0x3F), bcd(regs[1]), bcd(regs[0] & 0x7F));
+}
+
+// The panel may still be reading the frame buffer
+static void buffer_wait() {
+  twi_panel_wait();
+}
+
+#else
+
+#if JIV_PAGE_BUFFER == 1
+U8G2_SH1106_128X64_NONAME_1_HW_I2C u8g2(U8G2_R0, /* reset=*/ U8X8_PIN_NONE);
+#elif JIV_PAGE_BUFFER == 2
+U8G2_SH1106_128X64_NONAME_2_HW_I2C u8g2(U8G2_R0, /* reset=*/ U8X8_PIN_NONE);
+#else
+U8G2_SH1106_128X64_NONAME_F_HW_I2C u8g2(U8G2_R0, /* reset=*/ U8X8_PIN_NONE);
+#endif
+RTC_DS1307 rtc;
+
+static bool rtc_begin() {
+  return rtc.begin();
+}
+
+static DateTime rtc_now() {
+  return rtc.now();
+}
+
+static void rtc_read_nvram(uint8_t address, uint8_t *data, uint8_t len) {
+  rtc.readnvram(data, len, address);
+}
+
+static void rtc_write_nvram(uint8_t address, const uint8_t *data, uint8_t len) {
+  rtc.writenvram(address, data, len);
+}
+
+static void buffer_wait() {
+}
+
+#endif
+volatile bool woke_by_button = false;
+static byte prevADCSRA;
+static uint32_t i2c_count = 0;
+
+/**
+ * Serial
+ * The game owns the USART instead of going through the core's Serial. Nothing references Serial, so
+ * HardwareSerial (its ISRs and 128 bytes of buffers) isn't linked and USART_UDRE_vect is free.
+ * 250000 baud is exact at 16 MHz with U2X. The ring has one writer (hal_serial_write) and one reader
+ * (the ISR), each moving only its own index.
+ */
+static const uint8_t tx_size = 64;
+static volatile uint8_t tx_ring[tx_size];
+static volatile uint8_t tx_head = 0;
+static volatile uint8_t tx_tail = 0;
+
+static void serial_begin() {
+  UBRR0 = F_CPU / 8 / hal_serial_baud - 1;
+  UCSR0A = bit(U2X0);
+  UCSR0C = bit(UCSZ01) | bit(UCSZ00);  // 8N1
+  UCSR0B = bit(TXEN0);
+}
+
+static void serial_drain() {
+  while (tx_head != tx_tail) {
+  }
+  // The last byte is still in the shift register once the ring is empty
+  while ((UCSR0A & bit(UDRE0)) == 0) {
+  }
+}
+
+uint8_t hal_serial_free() {
+  return (uint8_t)(tx_tail - tx_head - 1) % tx_size;
+}
+
+void hal_serial_write(const uint8_t *data, uint8_t len) {
+  for (uint8_t i = 0; i < len; i++) {
+    uint8_t next = (tx_head + 1) % tx_size;
+    if (next == tx_tail) {
+      break;
+    }
+    tx_ring[tx_head] = data[i];
+    tx_head = next;
+  }
+  UCSR0B |= bit(UDRIE0);
+}
+
+ISR (USART_UDRE_vect) {
+  if (tx_head == tx_tail) {
+    UCSR0B &= ~bit(UDRIE0);
+    return;
+  }
+  UDR0 = tx_ring[tx_tail];
+  tx_tail = (tx_tail + 1) % tx_size;
+}
+
+bool hal_begin() {
+  serial_begin();
+#if JIV_TWI_ASYNC
+  twi_begin();
+#endif
+
+  u8g2.begin();
+  u8g2.clear();
+  u8g2.setFont(game_font);
+
+  pinMode(buttonA, INPUT_PULLUP);
+  pinMode(buttonB, INPUT_PULLUP);
+  pinMode(buttonC, INPUT_PULLUP);
+
+  // Buttons A/B/C are PD2-PD4 (PCINT18-20), all on pin change interrupt 2
+  PCMSK2 |= bit(PCINT18) | bit(PCINT19) | bit(PCINT20);
+  PCIFR = bit(PCIF2);
+  PCICR |= bit(PCIE2);
+
+  return rtc_begin();
+}
+
+/**
+ * Clock
+ */
+
+uint32_t hal_millis() {
+  return millis();
+}
+
+void hal_delay(uint32_t ms) {
+  delay(ms);
+}
+
+void hal_yield_until(uint32_t ms) {
+  // Idle mode stops only the CPU clock: timer 0 wakes it every millisecond to look at the time again, and
+  // the button, TWI and USART interrupts keep working and wake it too
+  set_sleep_mode(SLEEP_MODE_IDLE);
+  while (true) {
+    noInterrupts();
+    if ((int32_t)(ms - millis()) <= 0 || input_queued()) {
+      interrupts();
+      return;
+    }
+    // Interrupts come back after the SLEEP, so one that fires between the check and here still wakes it
+    sleep_enable();
+    interrupts();
+    sleep_cpu();
+    sleep_disable();
+  }
+}
+
+DateTime hal_rtc_now() {
+  // Register pointer write, then the 7 byte read
+  i2c_count += 2;
+  return rtc_now();
+}
+
+/**
+ * Input
+ * Edges are picked up by the pin change interrupt below and queued in input.cpp
+ */
+
+bool hal_pressed(uint8_t pin) {
+  return digitalRead(pin) == LOW;
+}
+
+static const uint8_t button_mask = bit(PD2) | bit(PD3) | bit(PD4);
+static uint8_t button_pins = button_mask;
+
+ISR (PCINT2_vect) {
+  uint8_t pins = PIND & button_mask;
+  uint8_t changed = pins ^ button_pins;
+  button_pins = pins;
+
+  uint32_t ms = millis();
+  for (uint8_t pin = buttonA; pin <= buttonC; pin++) {
+    if (changed & bit(pin)) {
+      // Pulled up, so pressed reads low
+      input_edge(pin, !(pins & bit(pin)), ms);
+    }
+  }
+}
+
+/**
+ * Storage
+ */
+
+void hal_storage_read(int address, void *data, size_t len) {
+  uint8_t *bytes = (uint8_t *)data;
+  for (size_t i = 0; i < len; i++) {
+    bytes[i] = EEPROM.read(address + i);
+  }
+}
+
+void hal_storage_write(int address, const void *data, size_t len) {
+  const uint8_t *bytes = (const uint8_t *)data;
+  for (size_t i = 0; i < len; i++) {
+    EEPROM.update(address + i, bytes[i]);
+  }
+}
+
+/**
+ * RTC NVRAM
+ */
+
+void hal_nvram_read(uint8_t address, void *data, uint8_t len) {
+  // Register pointer write, then the read
+  i2c_count += 2;
+  rtc_read_nvram(address, (uint8_t *)data, len);
+}
+
+void hal_nvram_write(uint8_t address, const void *data, uint8_t len) {
+  i2c_count += 1;
+  rtc_write_nvram(address, (const uint8_t *)data, len);
+}
+
+/**
+ * Entropy
+ * The watchdog runs off its own RC oscillator, so how many micros() go by during a 16 ms watchdog
+ * period wobbles from one period to the next. Eight of those, the low bits of a floating A0 and the RTC
+ * time are folded together.
+ */
+static volatile bool watchdog_fired = false;
+
+static uint32_t fold(uint32_t e, uint32_t sample) {
+  e = ((e << 7) | (e >> 25)) ^ sample;
+  return e * 0x9E3779B1UL;
+}
+
+uint32_t hal_entropy() {
+  uint32_t e = fold(0, hal_rtc_now().unixtime());
+  for (uint8_t i = 0; i < 8; i++) {
+    watchdog_fired = false;
+    noInterrupts();
+    wdt_reset();
+    WDTCSR = bit(WDCE) | bit(WDE);
+    WDTCSR = bit(WDIE);  // interrupt only, 16 ms
+    interrupts();
+    while (!watchdog_fired) {
+    }
+    e = fold(e, micros());
+    e = fold(e, analogRead(A0));
+  }
+  return e;
+}
+
+/**
+ * Display
+ */
+
+void hal_display_first_page() {
+  buffer_wait();
+  u8g2.firstPage();
+}
+
+bool hal_display_next_page() {
+  return u8g2.nextPage() != 0;
+}
+
+void hal_display_clear_buffer() {
+  buffer_wait();
+  u8g2.clearBuffer();
+}
+
+void hal_display_update_area(uint8_t tx, uint8_t ty, uint8_t tw, uint8_t th) {
+#if JIV_TWI_ASYNC
+  // Queued straight from the frame buffer, one run per page
+  u8x8_t *u8x8 = u8g2.getU8x8();
+  uint8_t *buffer = u8g2.getBufferPtr();
+  uint16_t row_bytes = u8g2.getBufferTileWidth() * 8;
+  for (uint8_t ty_end = ty + th; ty < ty_end; ty++) {
+    twi_panel_write(u8x8_GetI2CAddress(u8x8) >> 1, ty, tx * 8 + u8x8->x_offset, buffer + ty * row_bytes + tx * 8, tw * 8);
+  }
+#else
+  u8g2.updateDisplayArea(tx, ty, tw, th);
+#endif
+}
+
+void hal_display_bitmap(int posx, int posy, int width, int height, const unsigned char *pic) {
+  buffer_wait();
+  u8g2.drawXBMP(posx, posy, width, height, pic);
+}
+
+void hal_display_bitmap_ram(int posx, int posy, int width, int height, const unsigned char *pic) {
+  buffer_wait();
+  u8g2.drawXBM(posx, posy, width, height, pic);
+}
+
+void hal_display_text(int posx, int posy, const char *text) {
+  buffer_wait();
+  u8g2.drawStr(posx, posy, text);
+}
+
+void hal_display_text(int posx, int posy, const __FlashStringHelper *text) {
+  buffer_wait();
+  u8g2.setCursor(posx, posy);
+  u8g2.print(text);
+}
+
+int hal_display_text_width(const char *text) {
+  return u8g2.getStrWidth(text);
+}
+
+int hal_display_text_width(const __FlashStringHelper *text) {
+  // u8g2 can only measure strings in RAM; every string the game draws fits in a display line
+  char line[24];
+  strncpy_P(line, (const char *)text, sizeof(line) - 1);
+  line[sizeof(line) - 1] = '\0';
+  return u8g2.getStrWidth(line);
+}
+
+int hal_display_ascent() {
+  return u8g2.getAscent();
+}
+
+int hal_display_descent() {
+  return -u8g2.getDescent();
+}
+
+void hal_display_power_save(bool enable) {
+  i2c_count += 1;
+  u8g2.setPowerSave(enable ? 1 : 0);
+}
+
+void hal_display_contrast(uint8_t level) {
+  i2c_count += 1;
+  u8g2.setContrast(level);
+}
+
+const uint8_t *hal_display_buffer(uint16_t& len) {
+  len = 8 * u8g2.getBufferTileHeight() * u8g2.getBufferTileWidth();
+  return u8g2.getBufferPtr();
+}
+
+uint32_t hal_i2c_count() {
+  return i2c_count;
+}
+
+/**
+ * Button Interrupt
+ * Gets called when the wake button is pressed
+ */
+void sleep_wake() {
+  sleep_disable();
+  wdt_disable();
+  woke_by_button = true;
+  detachInterrupt(digitalPinToInterrupt(buttonA));
+}
+
+/**
+ * Sleep
+ * Power down between watchdog wakes, so that a potential connected battery doesn't get drained
+ */
+
+void hal_sleep_begin() {
+  // Power down stops the USART mid-byte, and the TWI
+  serial_drain();
+#if JIV_TWI_ASYNC
+  twi_wait();
+#endif
+  prevADCSRA = ADCSRA;
+  ADCSRA = 0;
+  // Only the wake button may end a sleep period
+  PCICR &= ~bit(PCIE2);
+  set_sleep_mode(SLEEP_MODE_PWR_DOWN);
+  sleep_enable();
+}
+
+bool hal_sleep_wait(bool timed) {
+  woke_by_button = false;
+
+  noInterrupts();
+
+  if (timed) {
+    // clear various "reset" flags
+    MCUSR = 0; 	// allow changes, disable reset
+    WDTCSR = bit (WDCE) | bit(WDE); // set interrupt mode and an interval
+    WDTCSR = bit (WDIE) | bit(WDP3) | bit(WDP0); // set WDIE, and 8 second delay https://microcontrollerslab.com/arduino-watchdog-timer-tutorial/
+    wdt_reset();
+  }
+
+  // Configure wake button
+  attachInterrupt(digitalPinToInterrupt(buttonA), sleep_wake, LOW);
+
+  // BOD only stays off if sleep_cpu() comes within 3 cycles of setting BODS; it is back on after the wake
+  interrupts();
+  sleep_bod_disable();
+  sleep_cpu();
+
+  return woke_by_button;
+}
+
+void hal_sleep_end() {
+  sleep_disable();
+  ADCSRA = prevADCSRA;
+  button_pins = PIND & button_mask;
+  PCIFR = bit(PCIF2);
+  PCICR |= bit(PCIE2);
+}
+
+/**
+ * Interrupts
+ */
+
+// When WatchDog timer causes µC to wake it comes here
+ISR (WDT_vect) {
+	// Turn off watchdog, we don't want it to do anything (like resetting this sketch)
+	wdt_disable();
+	watchdog_fired = true;
+}
+
+#endif
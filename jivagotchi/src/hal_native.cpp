@@ -0,0 +1,358 @@
+/*
+ * Jiva-gotchi: Native Backend
+ * Runs the game on the host. Time is virtual: delays and yields advance it instead of waiting,
+ * so hours of play finish in milliseconds. Buttons come from a script that is sampled every virtual
+ * millisecond while awake, standing in for the pin change interrupt. EEPROM and the RTC's NVRAM are
+ * RAM arrays.
+*/
+
+#ifndef ARDUINO
+
+#include "hal.h"
+#include "input.h"
+#include "hal_native_font.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+static uint32_t virtual_ms = 0;
+static uint32_t rtc_base = 946684800UL;
+static hal_native_input input_script = NULL;
+static bool script_held[3];
+static FILE *serial_out = NULL;
+static uint32_t entropy = 0;
+static uint32_t i2c_count = 0;
+static uint8_t eeprom[1024];
+static bool eeprom_ready = false;
+static uint8_t nvram[hal_nvram_size];
+static uint8_t framebuffer[128 * 64 / 8];
+static uint8_t panel[128 * 64 / 8];
+static int page_top = 0;
+static uint8_t contrast = 0xCF;
+
+#ifdef JIV_PAGE_BUFFER
+static const int page_height = JIV_PAGE_BUFFER * 8;
+#else
+static const int page_height = 64;
+#endif
+
+/**
+ * Advance
+ * Moves the virtual clock forward a millisecond at a time, feeding button edges to the input queue
+ */
+static void advance(uint32_t ms) {
+  while (ms-- > 0) {
+    virtual_ms += 1;
+    if (input_script == NULL) {
+      continue;
+    }
+    for (uint8_t i = 0; i < 3; i++) {
+      bool held = input_script(buttonA + i, virtual_ms);
+      if (held != script_held[i]) {
+        script_held[i] = held;
+        input_edge(buttonA + i, held, virtual_ms);
+      }
+    }
+  }
+}
+
+/**
+ * Backend hooks
+ */
+
+void hal_native_set_input(hal_native_input input) {
+  input_script = input;
+}
+
+void hal_native_set_rtc(uint32_t unixtime) {
+  rtc_base = unixtime - virtual_ms / 1000;
+}
+
+void hal_native_advance(uint32_t ms) {
+  advance(ms);
+}
+
+void hal_native_set_entropy(uint32_t seed) {
+  entropy = seed;
+}
+
+void hal_native_set_serial(FILE *out) {
+  serial_out = out;
+}
+
+bool hal_begin() {
+  memset(framebuffer, 0, sizeof(framebuffer));
+  memset(panel, 0, sizeof(panel));
+  return true;
+}
+
+/**
+ * Clock
+ */
+
+uint32_t hal_millis() {
+  return virtual_ms;
+}
+
+void hal_delay(uint32_t ms) {
+  advance(ms);
+}
+
+void hal_yield_until(uint32_t ms) {
+  if ((int32_t)(ms - virtual_ms) > 0) {
+    advance(ms - virtual_ms);
+  }
+}
+
+DateTime hal_rtc_now() {
+  i2c_count += 2;
+  return DateTime(rtc_base + virtual_ms / 1000);
+}
+
+/**
+ * Input
+ */
+
+bool hal_pressed(uint8_t pin) {
+  return input_script != NULL && input_script(pin, virtual_ms);
+}
+
+/**
+ * Storage
+ * Starts out erased (0xFF), like a fresh ATmega328P
+ */
+
+static void eeprom_init() {
+  if (!eeprom_ready) {
+    memset(eeprom, 0xFF, sizeof(eeprom));
+    eeprom_ready = true;
+  }
+}
+
+void hal_storage_read(int address, void *data, size_t len) {
+  eeprom_init();
+  memcpy(data, eeprom + address, len);
+}
+
+void hal_storage_write(int address, const void *data, size_t len) {
+  eeprom_init();
+  memcpy(eeprom + address, data, len);
+}
+
+/**
+ * RTC NVRAM
+ * Starts out zeroed, holding no valid record, like a DS1307 that just had its coin cell put in
+ */
+
+void hal_nvram_read(uint8_t address, void *data, uint8_t len) {
+  i2c_count += 2;
+  memcpy(data, nvram + address, len);
+}
+
+void hal_nvram_write(uint8_t address, const void *data, uint8_t len) {
+  i2c_count += 1;
+  memcpy(nvram + address, data, len);
+}
+
+/**
+ * Entropy
+ * Whatever the host program asked for, so runs repeat
+ */
+uint32_t hal_entropy() {
+  return entropy;
+}
+
+/**
+ * Display
+ * A 128x64 monochrome buffer plus a copy standing in for the panel, which only changes when the buffer
+ * is sent. Text is drawn in a 5x7 font on a 6 pixel pitch, so it takes up roughly the space u8g2's
+ * ncenB08 does on the Uno. Pages are emulated the same way u8g2 does them, drawing outside the current
+ * page is dropped.
+ */
+
+static void set_pixel(int px, int py, bool on) {
+  if (px < 0 || px >= 128 || py < page_top || py >= page_top + page_height) {
+    return;
+  }
+  uint8_t mask = 1 << (py % 8);
+  if (on) {
+    framebuffer[(py / 8) * 128 + px] |= mask;
+  } else {
+    framebuffer[(py / 8) * 128 + px] &= ~mask;
+  }
+}
+
+void hal_display_first_page() {
+  page_top = 0;
+  memset(framebuffer, 0, sizeof(framebuffer));
+}
+
+bool hal_display_next_page() {
+  memcpy(panel + page_top / 8 * 128, framebuffer + page_top / 8 * 128, 128 * page_height / 8);
+  page_top += page_height;
+  if (page_top >= 64) {
+    page_top = 0;
+    return false;
+  }
+  return true;
+}
+
+void hal_display_clear_buffer() {
+  memset(framebuffer, 0, sizeof(framebuffer));
+}
+
+void hal_display_update_area(uint8_t tx, uint8_t ty, uint8_t tw, uint8_t th) {
+  for (uint8_t y = ty; y < ty + th && y < 8; y++) {
+    memcpy(panel + y * 128 + tx * 8, framebuffer + y * 128 + tx * 8, tw * 8);
+  }
+}
+
+void hal_display_bitmap(int posx, int posy, int width, int height, const unsigned char *pic) {
+  int row_bytes = (width + 7) / 8;
+  for (int y = 0; y < height; y++) {
+    for (int x = 0; x < width; x++) {
+      set_pixel(posx + x, posy + y, (pic[y * row_bytes + x / 8] >> (x % 8)) & 1);
+    }
+  }
+}
+
+void hal_display_bitmap_ram(int posx, int posy, int width, int height, const unsigned char *pic) {
+  hal_display_bitmap(posx, posy, width, height, pic);
+}
+
+void hal_display_text(int posx, int posy, const char *text) {
+  // posy is the baseline, like u8g2; the font is transparent, only set pixels are drawn
+  for (; *text != '\0'; text++, posx += 6) {
+    uint8_t c = *text;
+    if (c < native_font_first || c > native_font_last) {
+      continue;
+    }
+    for (int x = 0; x < native_font_columns; x++) {
+      uint8_t column = native_font[c - native_font_first][x];
+      for (int y = 0; y < 8; y++) {
+        if ((column >> y) & 1) {
+          set_pixel(posx + x, posy - 7 + y, true);
+        }
+      }
+    }
+  }
+}
+
+void hal_display_text(int posx, int posy, const __FlashStringHelper *text) {
+  hal_display_text(posx, posy, reinterpret_cast<const char *>(text));
+}
+
+int hal_display_text_width(const char *text) {
+  return 6 * strlen(text);
+}
+
+int hal_display_text_width(const __FlashStringHelper *text) {
+  return hal_display_text_width(reinterpret_cast<const char *>(text));
+}
+
+int hal_display_ascent() {
+  return 7;
+}
+
+int hal_display_descent() {
+  return 1;
+}
+
+void hal_display_power_save(bool enable) {
+  (void)enable;
+  i2c_count += 1;
+}
+
+void hal_display_contrast(uint8_t level) {
+  contrast = level;
+  i2c_count += 1;
+}
+
+uint8_t hal_native_contrast() {
+  return contrast;
+}
+
+const uint8_t *hal_display_buffer(uint16_t& len) {
+  len = 128 * page_height / 8;
+  return framebuffer + page_top / 8 * 128;
+}
+
+uint32_t hal_i2c_count() {
+  return i2c_count;
+}
+
+/**
+ * Capture
+ * The panel is what was last sent to the screen, in the SH1106's layout: 8 pages of 128 columns, bit 0
+ * at the top of each page
+ */
+
+const uint8_t *hal_native_panel() {
+  return panel;
+}
+
+bool hal_native_pixel(int x, int y) {
+  return (panel[(y / 8) * 128 + x] >> (y % 8)) & 1;
+}
+
+bool hal_native_capture(const char *path) {
+  FILE *file = fopen(path, "wb");
+  if (file == NULL) {
+    return false;
+  }
+  // Binary PBM: rows of packed pixels, most significant bit first, 1 is black. Lit pixels come out black.
+  fprintf(file, "P4\n128 64\n");
+  for (int y = 0; y < 64; y++) {
+    for (int x = 0; x < 128; x += 8) {
+      uint8_t bits = 0;
+      for (int i = 0; i < 8; i++) {
+        bits = (bits << 1) | hal_native_pixel(x + i, y);
+      }
+      fputc(bits, file);
+    }
+  }
+  return fclose(file) == 0;
+}
+
+/**
+ * Sleep
+ * One watchdog period is eight seconds of virtual time. Buttons aren't sampled while asleep, only the
+ * wake button at the end of each period; an untimed sleep checks it every virtual second.
+ */
+
+void hal_sleep_begin() {
+}
+
+bool hal_sleep_wait(bool timed) {
+  if (input_script == NULL) {
+    virtual_ms += hal_sleep_period_s * 1000UL;
+    return false;
+  }
+  if (timed) {
+    virtual_ms += hal_sleep_period_s * 1000UL;
+    return input_script(buttonA, virtual_ms);
+  }
+  do {
+    virtual_ms += 1000;
+  } while (!input_script(buttonA, virtual_ms));
+  return true;
+}
+
+void hal_sleep_end() {
+}
+
+/**
+ * Serial
+ * The host is never short of buffer space, so every frame goes through
+ */
+
+uint8_t hal_serial_free() {
+  return 255;
+}
+
+void hal_serial_write(const uint8_t *data, uint8_t len) {
+  if (serial_out != NULL) {
+    fwrite(data, 1, len, serial_out);
+  }
+}
+
+#endif
@@ -0,0 +1,116 @@
+/*
+ * Jiva-gotchi: Input Events
+ * The ring buffer has a single writer (the interrupt) and a single reader (the game loop), so head and
+ * tail each only ever change on one side. The reader's own writes (long presses and resyncing a missed
+ * release) are made with interrupts off.
+*/
+
+#include "input.h"
+
+#ifdef ARDUINO
+#include <util/atomic.h>
+#define INPUT_CRITICAL ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+#else
+#define INPUT_CRITICAL
+#endif
+
+static const uint8_t queue_size = 8;
+static const uint8_t buttons = 3;
+
+static volatile input_event queue[queue_size];
+static volatile uint8_t head = 0;
+static volatile uint8_t tail = 0;
+
+static volatile bool held[buttons];
+static volatile uint32_t edge_ms[buttons];
+static bool long_sent[buttons];
+static volatile uint32_t last_edge_ms = 0;
+
+/**
+ * Push
+ * Appends an event, dropping it if the queue is full
+ */
+static void push(uint8_t button, uint8_t type, uint32_t ms) {
+  uint8_t next = (head + 1) % queue_size;
+  if (next == tail) {
+    return;
+  }
+  queue[head].button = button;
+  queue[head].type = type;
+  queue[head].ms = ms;
+  head = next;
+}
+
+void input_edge(uint8_t button, bool pressed, uint32_t ms) {
+  uint8_t i = button - buttonA;
+  if (i >= buttons || held[i] == pressed) {
+    return;
+  }
+  if ((ms - edge_ms[i]) < input_debounce_ms) {
+    return;
+  }
+  held[i] = pressed;
+  edge_ms[i] = ms;
+  last_edge_ms = ms;
+  push(button, pressed ? input_press : input_release, ms);
+}
+
+/**
+ * Update
+ * Adds long presses, and catches up with a button whose last edge was swallowed by the debounce
+ */
+static void input_update() {
+  uint32_t ms = hal_millis();
+  for (uint8_t i = 0; i < buttons; i++) {
+    INPUT_CRITICAL {
+      if ((ms - edge_ms[i]) >= input_debounce_ms && hal_pressed(buttonA + i) != held[i]) {
+        input_edge(buttonA + i, !held[i], ms);
+      }
+      if (!held[i]) {
+        long_sent[i] = false;
+      } else if (!long_sent[i] && (ms - edge_ms[i]) >= input_long_press_ms) {
+        long_sent[i] = true;
+        push(buttonA + i, input_long_press, ms);
+      }
+    }
+  }
+}
+
+bool input_read(input_event& event) {
+  input_update();
+  if (tail == head) {
+    return false;
+  }
+  event.button = queue[tail].button;
+  event.type = queue[tail].type;
+  event.ms = queue[tail].ms;
+  tail = (tail + 1) % queue_size;
+  return true;
+}
+
+uint8_t input_next_press() {
+  input_event event;
+  while (input_read(event)) {
+    if (event.type == input_press) {
+      return event.button;
+    }
+  }
+  return 0;
+}
+
+uint32_t input_last_edge() {
+  uint32_t ms;
+  INPUT_CRITICAL {
+    ms = last_edge_ms;
+  }
+  return ms;
+}
+
+bool input_queued() {
+  return head != tail;
+}
+
+void input_flush() {
+  input_update();
+  tail = head;
+}
@@ -0,0 +1,148 @@
+/*
+ * Jiva-gotchi: Save Journal
+*/
+
+#include "journal.h"
+
+#ifdef ARDUINO
+#include <util/crc16.h>
+#endif
+
+/**
+ * Slot address
+ */
+static int slot_address(const journal& j, uint8_t slot) {
+  return j.base + slot * journal_slot_size;
+}
+
+/**
+ * CRC
+ * CRC-CCITT over the sequence number, the payload length and the payload
+ */
+static uint16_t record_crc(uint16_t seq, const uint8_t *data, uint8_t len) {
+  uint16_t crc = 0xFFFF;
+  crc = _crc_ccitt_update(crc, seq & 0xFF);
+  crc = _crc_ccitt_update(crc, seq >> 8);
+  crc = _crc_ccitt_update(crc, len);
+  for (uint8_t i = 0; i < len; i++) {
+    crc = _crc_ccitt_update(crc, data[i]);
+  }
+  return crc;
+}
+
+/**
+ * Load slot
+ * Reads a slot and checks it
+ *
+ * @return  True if the record in the slot is valid
+ */
+static bool load_slot(const journal& j, uint8_t slot, uint8_t len, uint16_t& seq, uint8_t *data) {
+  uint16_t crc;
+  int address = slot_address(j, slot);
+  hal_storage_get(address, seq);
+  hal_storage_get(address + 2, crc);
+  hal_storage_read(address + journal_header_size, data, len);
+  // 0xFFFF is never written, so erased EEPROM can't pass as a record
+  return seq != 0xFFFF && crc == record_crc(seq, data, len);
+}
+
+void journal_open(journal& j, int base, uint8_t slots, uint8_t len) {
+  uint8_t data[journal_payload_size];
+
+  j.base = base;
+  j.slots = slots;
+  j.newest = slots - 1;
+  j.seq = 0;
+  j.valid = false;
+  j.pending = 0;
+
+  for (uint8_t slot = 0; slot < slots; slot++) {
+    uint16_t seq;
+    if (!load_slot(j, slot, len, seq, data)) {
+      continue;
+    }
+    // Live sequence numbers are never more than a lap of the slots apart, so this survives wrapping
+    if (!j.valid || (int16_t)(seq - j.seq) > 0) {
+      j.newest = slot;
+      j.seq = seq;
+      j.valid = true;
+    }
+  }
+}
+
+bool journal_read(const journal& j, void *data, uint8_t len) {
+  if (!j.valid) {
+    return false;
+  }
+  uint16_t seq;
+  return load_slot(j, j.newest, len, seq, (uint8_t *)data);
+}
+
+bool journal_stage(journal& j, const void *data, uint8_t len) {
+  // Finish whatever was staged before, the new record goes after it
+  journal_step(j, 0xFF);
+
+  if (j.valid) {
+    uint8_t current[journal_payload_size];
+    hal_storage_read(slot_address(j, j.newest) + journal_header_size, current, len);
+    if (memcmp(current, data, len) == 0) {
+      return false;
+    }
+  }
+
+  uint16_t seq = j.seq + 1;
+  if (seq == 0xFFFF) {
+    seq = 0;
+  }
+  uint16_t crc = record_crc(seq, (const uint8_t *)data, len);
+  memcpy(j.record, &seq, 2);
+  memcpy(j.record + 2, &crc, 2);
+  memcpy(j.record + journal_header_size, data, len);
+  j.len = len;
+  j.pending = journal_header_size + len;
+  return true;
+}
+
+bool journal_step(journal& j, uint8_t max_bytes) {
+  if (j.pending == 0) {
+    return true;
+  }
+
+  uint8_t slot = (j.newest + 1) % j.slots;
+  int address = slot_address(j, slot);
+  uint8_t total = journal_header_size + j.len;
+
+  // Payload first and header last, sequence number very last: a record cut short never gets a matching CRC
+  while (max_bytes-- > 0 && j.pending > 0) {
+    uint8_t written = total - j.pending;
+    uint8_t offset = (written < j.len) ? journal_header_size + written : j.len + journal_header_size - 1 - written;
+    hal_storage_write(address + offset, j.record + offset, 1);
+    j.pending--;
+  }
+  if (j.pending > 0) {
+    return false;
+  }
+
+  memcpy(&j.seq, j.record, 2);
+  j.newest = slot;
+  j.valid = true;
+  return true;
+}
+
+bool journal_pending(const journal& j) {
+  return j.pending > 0;
+}
+
+uint16_t journal_next_seq(const journal& j) {
+  uint16_t seq = j.seq;
+  if (j.pending > 0) {
+    memcpy(&seq, j.record, 2);
+  }
+  return seq;
+}
+
+void journal_write(journal& j, const void *data, uint8_t len) {
+  if (journal_stage(j, data, len)) {
+    journal_step(j, 0xFF);
+  }
+}
@@ -5,982 +5,341 @@
  * Licensed under GPL v3.0
 */
 
-#include <Arduino.h>
-#include <avr/sleep.h>
-#include <avr/wdt.h>
-#include <avr/pgmspace.h>
-#include <U8g2lib.h>
-#include <EEPROM.h>
-#include <RTClib.h>
-
-/**
- * Pin Definitions
- */
-
-#define buttonA 2 
-#define buttonB 3
-#define buttonC 4
-
-/**
- * Tamagotchi Class
- * Holds all the values related to the user's tamagotchi
- */
-class tamagotchi {
-  
-  public:
-    int hunger;
-    int happy;
-    int discipline;
-    int level;
-    bool health;
-    bool soiled;
-    bool misbehave;
-    int snacks_fed;
-    DateTime birth;
-
-    tamagotchi() {
-      hunger = 50;
-      happy = 50;
-      discipline = 0;
-      level = 1;
-      health = true;
-      soiled = true;
-      misbehave = false;
-      snacks_fed = 0;
-    }
-
-    void print() {
-      Serial.println();
-      Serial.print(F("Happy: "));
-      Serial.println(happy);
-      Serial.print(F("Hunger: "));
-      Serial.println(hunger);
-      Serial.print(F("Health: "));
-      Serial.println(health);
-      Serial.print(F("Discipline: "));
-      Serial.println(discipline);
-      Serial.print(F("Level: "));
-      Serial.println(level);
-      Serial.print(F("Soiled: "));
-      Serial.println(soiled);
-      Serial.print(F("Birthday: "));
-      Serial.println(birth.unixtime());
-    }
-};
+#include "game.h"
+#include "display.h"
+#include "clock.h"
+#include "telemetry.h"
+#include "rng.h"
+#include "pets.h"
+#include "power.h"
+#include "input.h"
 
 /**
  * Global Variables
  */
-// volatile char sleepCnt = 0;
-DateTime now, then, last_action;
-tamagotchi jiv;
-U8G2_SH1106_128X64_NONAME_F_HW_I2C u8g2(U8G2_R0, /* reset=*/ U8X8_PIN_NONE);
-RTC_DS1307 rtc;
-bool pass_time, over_under, right_left, heal_tama, scold_tama, clean_tama, feed_tama;
-bool changed = true;
-bool night_sleep = false;
-bool sleep_tama = false;
-const char* activities[7] = {
-  "Up/Down",
-  "R/L",
-  "Heal",
-  "Scold",
-  "Clean",
-  "Feed",
-  "Sleep"
-};
+action ui;
 
 /**
- * Bitmaps
+ * Menu Entries
+ * What the menu offers, in order: a label, the action it starts and an 8x8 XBM icon, all in flash.
+ * A new activity is one more row here. Telemetry reports picks by their index in this table.
  */
-static const int idle_width = 16;
-static const int idle_height = 24;
-
-static const unsigned char level_1_idle_0_bits[] PROGMEM = {
-  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-  0x00, 0x00, 0xf8, 0x1f, 0x08, 0x10, 0x08, 0x10, 0x08, 0x10, 0x08, 0x10,
-  0xe8, 0x38, 0xc8, 0x18, 0xc8, 0x18, 0x08, 0x10, 0x08, 0x10, 0x08, 0x10,
-  0xf8, 0x1f, 0x08, 0x10, 0x08, 0x10, 0xf8, 0x1f, 0x38, 0x0e, 0x18, 0x06
-};
-
-static const unsigned char level_1_idle_1_bits[] PROGMEM = {
-  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-  0x00, 0x00, 0x00, 0x00, 0xf8, 0x1f, 0x08, 0x10, 0x08, 0x10, 0x08, 0x10,
-  0x08, 0x10, 0xe8, 0x38, 0xc8, 0x18, 0xc8, 0x18, 0x08, 0x10, 0x08, 0x10,
-  0x08, 0x10, 0xf8, 0x1f, 0x08, 0x10, 0x08, 0x10, 0xf8, 0x1f, 0x38, 0x0e
-};
-
-static const unsigned char level_1_idle_2_bits[] PROGMEM = {
-  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xf8, 0x1f, 0x08, 0x10, 0x08, 0x10,
-  0x08, 0x10, 0x08, 0x10, 0xe8, 0x38, 0xc8, 0x18, 0xc8, 0x18, 0x08, 0x10,
-  0x08, 0x10, 0x08, 0x10, 0xf8, 0x1f, 0x08, 0x10, 0x08, 0x10, 0xf8, 0x1f
-};
-
-static const unsigned char level_1_idle_3_bits[] PROGMEM = {
-  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-  0x00, 0x00, 0x00, 0x00, 0xf8, 0x1f, 0x08, 0x10, 0x08, 0x10, 0x08, 0x10,
-  0x08, 0x10, 0xe8, 0x38, 0xc8, 0x18, 0xc8, 0x18, 0x08, 0x10, 0x08, 0x10,
-  0x08, 0x10, 0xf8, 0x1f, 0x08, 0x10, 0x08, 0x10, 0xf8, 0x1f, 0x38, 0x0e
-};
-
-static const unsigned char level_2_idle_0_bits[] PROGMEM = {
-  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-  0xf8, 0x1f, 0xf8, 0x1f, 0xf8, 0x1f, 0xf8, 0x1f, 0x38, 0x10, 0x18, 0x10,
-  0xf8, 0x38, 0xc8, 0x18, 0xc8, 0x18, 0x08, 0x10, 0x08, 0x10, 0x08, 0x10,
-  0xf8, 0x1f, 0x08, 0x10, 0x08, 0x10, 0xf8, 0x1f, 0x38, 0x0e, 0x18, 0x06
-};
-
-static const unsigned char level_2_idle_1_bits[] PROGMEM = {
-  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-  0x00, 0x00, 0xf8, 0x1f, 0xf8, 0x1f, 0xf8, 0x1f, 0xf8, 0x1f, 0x38, 0x10,
-  0x18, 0x10, 0xf8, 0x38, 0xc8, 0x18, 0xc8, 0x18, 0x08, 0x10, 0x08, 0x10,
-  0x08, 0x10, 0xf8, 0x1f, 0x08, 0x10, 0x08, 0x10, 0xf8, 0x1f, 0x38, 0x0e
-};
-
-static const unsigned char level_2_idle_2_bits[] PROGMEM = {
-  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-  0x00, 0x00, 0x00, 0x00, 0xf8, 0x1f, 0xf8, 0x1f, 0xf8, 0x1f, 0xf8, 0x1f,
-  0x38, 0x10, 0x18, 0x10, 0xf8, 0x38, 0xc8, 0x18, 0xc8, 0x18, 0x08, 0x10,
-  0x08, 0x10, 0x08, 0x10, 0xf8, 0x1f, 0x08, 0x10, 0x08, 0x10, 0xf8, 0x1f
-};
-
-static const unsigned char level_2_idle_3_bits[] PROGMEM = {
-  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-  0x00, 0x00, 0xf8, 0x1f, 0xf8, 0x1f, 0xf8, 0x1f, 0xf8, 0x1f, 0x38, 0x10,
-  0x18, 0x10, 0xf8, 0x38, 0xc8, 0x18, 0xc8, 0x18, 0x08, 0x10, 0x08, 0x10,
-  0x08, 0x10, 0xf8, 0x1f, 0x08, 0x10, 0x08, 0x10, 0xf8, 0x1f, 0x38, 0x0e
-};
-
-static const unsigned char level_3_idle_0_bits[] PROGMEM = {
-  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-  0x00, 0x00, 0xe0, 0x07, 0xf0, 0x0f, 0xf8, 0x1f, 0xf8, 0x1f, 0x3c, 0x10,
-  0x1c, 0x10, 0xdc, 0x18, 0xdc, 0x78, 0x3c, 0x70, 0xfc, 0x7f, 0xf8, 0x3f,
-  0xc8, 0x3f, 0x88, 0x1f, 0x08, 0x17, 0xc8, 0x13, 0x28, 0x0a, 0x18, 0x06 
+struct menu_entry {
+  const char *label;
+  action_fn handler;
+  const unsigned char *icon;
 };
 
-static const unsigned char level_3_idle_1_bits[] PROGMEM = {
-  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-  0x00, 0x00, 0x00, 0x00, 0xe0, 0x07, 0xf0, 0x0f, 0xf8, 0x1f, 0xf8, 0x1f,
-  0x3c, 0x10, 0x1c, 0x10, 0xdc, 0x18, 0xdc, 0x78, 0x3c, 0x70, 0xfc, 0x7f,
-  0xf8, 0x3f, 0xc8, 0x3f, 0x88, 0x1f, 0x08, 0x17, 0xc8, 0x13, 0x38, 0x0e 
+static const char label_over_under[] PROGMEM = "Up/Down";
+static const char label_right_left[] PROGMEM = "R/L";
+static const char label_heal[] PROGMEM = "Heal";
+static const char label_scold[] PROGMEM = "Scold";
+static const char label_clean[] PROGMEM = "Clean";
+static const char label_feed[] PROGMEM = "Feed";
+static const char label_sleep[] PROGMEM = "Sleep";
+static const char label_next_pet[] PROGMEM = "Next pet";
+
+static const unsigned char icon_over_under[] PROGMEM = { 0x08, 0x1c, 0x3e, 0x08, 0x08, 0x3e, 0x1c, 0x08 };
+static const unsigned char icon_right_left[] PROGMEM = { 0x00, 0x24, 0x66, 0xff, 0x66, 0x24, 0x00, 0x00 };
+static const unsigned char icon_heal[] PROGMEM = { 0x00, 0x18, 0x18, 0x7e, 0x7e, 0x18, 0x18, 0x00 };
+static const unsigned char icon_scold[] PROGMEM = { 0x18, 0x18, 0x18, 0x18, 0x18, 0x00, 0x18, 0x00 };
+static const unsigned char icon_clean[] PROGMEM = { 0x08, 0x08, 0x1c, 0x3e, 0x3e, 0x3e, 0x1c, 0x00 };
+static const unsigned char icon_feed[] PROGMEM = { 0x10, 0x08, 0x36, 0x7f, 0x7f, 0x7f, 0x3e, 0x14 };
+static const unsigned char icon_sleep[] PROGMEM = { 0x1c, 0x06, 0x03, 0x03, 0x03, 0x06, 0x1c, 0x00 };
+static const unsigned char icon_next_pet[] PROGMEM = { 0x12, 0x12, 0x21, 0x0c, 0x1e, 0x1e, 0x0c, 0x00 };
+
+static const menu_entry menu_entries[] PROGMEM = {
+  { label_over_under, overUnder, icon_over_under },
+  { label_right_left, rightLeft, icon_right_left },
+  { label_heal, heal, icon_heal },
+  { label_scold, scold, icon_scold },
+  { label_clean, clean, icon_clean },
+  { label_feed, feed, icon_feed },
+  { label_sleep, tuck_in, icon_sleep },
+#if JIV_PETS > 1
+  { label_next_pet, next_pet, icon_next_pet },
+#endif
 };
-
-static const unsigned char level_3_idle_2_bits[] PROGMEM = {
-  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xe0, 0x07, 0xf0, 0x0f, 0xf8, 0x1f,
-  0xf8, 0x1f, 0x3c, 0x10, 0x1c, 0x10, 0xdc, 0x18, 0xdc, 0x78, 0x3c, 0x70,
-  0xfc, 0x7f, 0xf8, 0x3f, 0xc8, 0x3f, 0x88, 0x1f, 0x08, 0x17, 0xf8, 0x1f 
-};
-
-static const unsigned char level_3_idle_3_bits[] PROGMEM = {
-  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-  0x00, 0x00, 0x00, 0x00, 0xe0, 0x07, 0xf0, 0x0f, 0xf8, 0x1f, 0xf8, 0x1f,
-  0x3c, 0x10, 0x1c, 0x10, 0xdc, 0x18, 0xdc, 0x78, 0x3c, 0x70, 0xfc, 0x7f,
-  0xf8, 0x3f, 0xc8, 0x3f, 0x88, 0x1f, 0x08, 0x17, 0xc8, 0x13, 0x38, 0x0e 
-};
-
-static const unsigned char level_4_idle_0_bits[] PROGMEM = {
-  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xf0, 0x1f, 0x78, 0x10, 0x3c, 0x10,
-  0xfc, 0x38, 0xdc, 0x18, 0xdc, 0x18, 0x3c, 0x30, 0xfc, 0x7f, 0xf8, 0x3f,
-  0xf8, 0x3f, 0x88, 0x1f, 0x88, 0x1f, 0xf8, 0x1f, 0xb8, 0x0f, 0x98, 0x07
-};
-
-static const unsigned char level_4_idle_1_bits[] PROGMEM = {
-  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xf0, 0x1f, 0x78, 0x10,
-  0x3c, 0x10, 0xfc, 0x38, 0xdc, 0x18, 0xdc, 0x18, 0x3c, 0x30, 0xfc, 0x7f,
-  0xf8, 0x3f, 0xf8, 0x3f, 0x88, 0x1f, 0x88, 0x1f, 0xf8, 0x1f, 0xb8, 0x0f
-};
-
-static const unsigned char level_4_idle_2_bits[] PROGMEM = {
-  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xf0, 0x1f,
-  0x78, 0x10, 0x3c, 0x10, 0xfc, 0x38, 0xdc, 0x18, 0xdc, 0x18, 0x3c, 0x30,
-  0xfc, 0x7f, 0xf8, 0x3f, 0xf8, 0x3f, 0x88, 0x1f, 0x88, 0x1f, 0xf8, 0x1f
-};
-
-static const unsigned char level_4_idle_3_bits[] PROGMEM = {
-  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xf0, 0x1f, 0x78, 0x10,
-  0x3c, 0x10, 0xfc, 0x38, 0xdc, 0x18, 0xdc, 0x18, 0x3c, 0x30, 0xfc, 0x7f,
-  0xf8, 0x3f, 0xf8, 0x3f, 0x88, 0x1f, 0x88, 0x1f, 0xf8, 0x1f, 0xb8, 0x0f
-};
-
-/**
- * Function definitions
- */
-
-/**
- * Clear Screen
- * Clears the OLED screen so that a new frame can be shown
- */
-void clearScreen() {
-  u8g2.clear();
-  u8g2.clearBuffer();
-}
-
-/**
- * Print Image
- * Prints a bitmap image from flash memory
- * 
- * @param   width   The height of the image
- * @param   height  The width of the image
- * @param   pic     A PROGMEM variable containing the bitmap of the image
- * @param   clear   OPTIONAL - A boolean, true to clear the screen false to keep it (Default: True)
- * @param   posx    OPTIONAL - X Position of the image to be drawn (Default: 0)
- * @param   posy    OPTIONAL - Y Position of the image to be drawn (Default: 0)
- */
-void printImage(int width, int height, const unsigned char *pic, bool clear = true, int posx = 0, int posy = 0) {
-  if (clear) { 
-    clearScreen();
-  }
-  u8g2.drawXBMP(posx, posy, width, height, pic);
-  u8g2.sendBuffer();
-}
+static const uint8_t menu_count = sizeof(menu_entries) / sizeof(menu_entries[0]);
 
 /**
- * Print Text
- * Prints text onto the display
- * 
- * @param   text    String to be printed
- * @param   clear   OPTIONAL - A boolean, true to clear the screen false to keep it (Default: True)
- * @param   posx    OPTIONAL - X Position of the image to be drawn (Default: 0)
- * @param   posy    OPTIONAL - Y Position of the image to be drawn (Default: 0)
- */
-void printText(const char *text, bool clear = true, int posx = 0, int posy = 0) {
-  if (clear) {
-    clearScreen();
-  }
-  // u8g2_font_ncenB08_tr
-  u8g2.setFont(u8g2_font_ncenB08_tr);
-  u8g2.drawStr(posx, posy, text);
-  u8g2.sendBuffer();
-}
-
-/**
- * Print F() Style Text
- * Because SRAM is a valuable resource
- * 
- * @param   text    The F() string
- * @param   clear   Whether or not to clear the screen before printing
- * @param   posx    X Position for printing
- * @param   posy    Y Position for printing
- */
-void print_f_text(const __FlashStringHelper* text, bool clear = true, int posx = 0, int posy = 0) {
-  if (clear) {
-    clearScreen();
-  }
-  u8g2.setCursor(posx, posy);
-  u8g2.print(text);
-  u8g2.sendBuffer();
-}
-
-/**
- * Write tama stats to EEPROM
- * 
- * @param   tama    The tama to be saved
- */
-void write_eeprom(tamagotchi& tama, bool screen = true) {
-  int tama_address = 0;
-  if (screen) {
-    print_f_text(F("Saving..."), true, 20, 20);
-  }
-  EEPROM.put(tama_address, tama);
-  if (screen) {
-    clearScreen();
-  }
-}
-
-/**
- * Read tama stats from EEPROM
- * 
- * @param   tama    The tama to be read into
- */
-void read_eeprom(tamagotchi& tama) {
-  int tama_address = 0;
-  print_f_text(F("Loading..."), true, 20, 20);
-  EEPROM.get(tama_address, tama);
-  tama.print();
-  delay(300);
-  clearScreen();
-}
-
-/**
- * Print Tama Stats
- * Displays tama data on the screen
- * 
- * @param   tama    Tamagotchi object containing requested data
- * @param   clear   Whether or not to clear the screen before displaying
- */
-void print_stats(tamagotchi& tama, bool clear = true) {
-  if (clear) {
-    clearScreen();
-  }
-
-  // For some ungodly reason, taking these out of the if statement breaks it
-  if (true) {
-      char happy[12];
-      snprintf(happy, sizeof(happy), "Happy: %d%%", tama.happy);
-      printText(happy, false, 0, 35);
-
-  }
-  if (true) {
-    char hunger[12];
-    snprintf(hunger, sizeof(hunger), "Hunger: %d%%", tama.hunger);
-    printText(hunger, false, 0, 45);
-
-  } 
-  if (true) {
-    char discipline[16];
-    snprintf(discipline, sizeof(discipline), "Discipline: %d%%", tama.discipline);
-    printText(discipline, false, 0, 55);
-
-  } 
-  if (true) {
-    char level[12];
-    snprintf(level, sizeof(level), "%d", tama.level);
-    printText(level, false, 20, 20);
-
-  } 
-    
-  if (!jiv.health) {
-    print_f_text(F(":("), false, 30, 20);
-  } 
-  
-  if (jiv.soiled) {
-    print_f_text(F("O.o"), false, 45, 20);
-  }
-  
-  if (jiv.misbehave) {
-    print_f_text(F(">:)"), false, 70, 20);
-  }
-}
-
-/**
- * Tama Balance Check
- * Make sure that certain tama values do not exceed/drop below their range
- * 
- * @param   tama    The tamagotchi object to be checked
- */
-void check_bal(tamagotchi& tama) {
-  if (tama.hunger > 100) {
-    tama.hunger = 100;
-  }
-  if (tama.happy > 100) {
-    tama.happy = 100;
-  }
-  if (tama.discipline > 100) {
-    tama.discipline = 100;
-  }
-  if (tama.level > 4) {
-    tama.level = 4;
-  }
-
-  if (tama.hunger < 0) {
-    tama.hunger = 0;
-  }
-  if (tama.happy < 0) {
-    tama.happy = 0;
-  }
-  if (tama.discipline < 0) {
-    tama.discipline = 0;
-  }
-  if (tama.level < 1) {
-    tama.level = 1;
-  }
-}
-
-/**
- * Processes the "life functions" of the tamagotchi (getting hungry, bored, bathroom, etc.)
- * This function lowers those values to facilitate gameplay
- * 
- * @param   tama    The tamagotchi object to be processed
+ * Menu Scene
+ * The currently highlighted activity
+ *
+ * @param   ctx     Index into menu_entries
  */
-void passTime(tamagotchi& tama) {
-  if (tama.soiled) {
-    // if tama pooped, make it sick 50% of the time
-    if (random(100) > 50) {
-      tama.health = false;
-    }
-  } else {
-    // otherwise make it poop, 25% of the time
-    if (random(100) > 75) {
-      tama.soiled = true;
-    }
-  }
-
-  if ((tama.happy <= 0) || (tama.hunger <= 0) || (tama.snacks_fed > 5)) {
-    // Make tama sick if its happiness or hunger is 0, or if it ate too many snacks
-    tama.health = false;
-  } else if ((random(tama.discipline) == tama.discipline) && (tama.discipline < 100)) {
-    // Misbehave change based on the discipline level
-    tama.misbehave = true;
-  } else {
-    tama.happy -= 5;
-    tama.hunger -= 5;
-  }
-
-  changed = true;
-  check_bal(tama);
+void scene_menu(const void *ctx) {
+  const menu_entry *entry = &menu_entries[*(const uint8_t *)ctx];
+  draw_bitmap(12, 18, 8, 8, (const unsigned char *)pgm_read_ptr(&entry->icon));
+  draw_text(25, 25, (const __FlashStringHelper *)pgm_read_ptr(&entry->label));
 }
 
 /**
- * Tamagotchi Game: Over Under
- * Guessing whether the second of two random numbers between 1 - 10 will be higher or lower than the first
- * Playing the game will increase the happiness level of the tamagotchi
- * 
- * TODO: Game splash screen?
- * 
- * @param   tama    The tamagotchi object to be processed
+ * Boot Prompt
+ * Load the save or start over. A with nothing saved starts a new tama too.
  */
-void overUnder(tamagotchi& tama) {
-  // Set up the game
-  int first = random(1, 11);
-  int second = random(1, 11);
-  bool user_guess;
-
-  // Display first number
-  char first_num[2];
-  sprintf(first_num, "%d", first);
-
-  // Prompt for input
-  printText(first_num, true, 0, 10);
-  print_f_text(F("Up A"), false, 0, 20);
-  print_f_text(F("Low B"), false, 0, 30);
-  print_f_text(F("Confirm C"), false, 0, 40);
-  while (digitalRead(buttonC) == HIGH) {
-    if (digitalRead(buttonA) == LOW) {
-      user_guess = true;
-      print_f_text(F("GUESS: OVER"), false, 0, 50);
-    } else if (digitalRead(buttonB) == LOW) {
-      user_guess = false;
-      print_f_text(F("GUESS: UNDER"), false, 0, 50);
+static void boot_prompt() {
+  checkpoint_hot();
+  frame_begin();
+  print_f_text(F("A: Load Saved Tama"), true, 10, 10);
+  print_f_text(F("B: New Tama"), false, 10, 20);
+  frame_commit();
+  input_flush();
+  while (true) {
+    uint8_t pressed = input_next_press();
+    if (pressed == buttonA && read_eeprom(jiv)) {
+      telemetry_event(event_boot, 1);
+      break;
+    } else if (pressed == buttonA || pressed == buttonB) {
+      // Only the pet on screen starts over, the others are still there
+      jiv.birth = clock_now();
+      jiv.ticked = jiv.birth;
+      pets_put(active_pet, jiv);
+      read_pets();
+      telemetry_event(event_boot, 0);
+      break;
     }
+    hal_yield_until(hal_millis() + button_poll_ms);
   }
-
-  // Evaluate and display results
-  char second_num[2];
-  sprintf(second_num, "%d", second);
-  if (((first < second) && user_guess) || ((first > second && !user_guess))) {
-    printText(first_num, true, 0, 10);
-    printText(second_num, false, 0, 20);
-    print_f_text(F("POGCHAMP"), false, 0, 30);
-  } else if (first == second) {
-    printText(first_num, true, 0, 10);
-    printText(second_num, false, 0, 20);
-    print_f_text(F("...no comment..."), false, 0, 30);
-  } else {
-    printText(first_num, true, 0, 10);
-    printText(second_num, false, 0, 20);
-    print_f_text(F("Sadge"), false, 0, 30);
-  }
-
-  delay(500);
-  // Set tama happiness level
-  tama.happy += 10;
-  changed = true;
-  check_bal(tama);
-  print_f_text(F("C to close."), false, 0, 50);
-  while (digitalRead(buttonC) == HIGH) {
-
-  }
+  clearScreen();
 }
 
 /**
- * Tamagotchi Game: Left Right
- * Guessing whether the tamagotchi will turn to the left or the right
- * Playing the game will increase the happiness level of the tamagotchi
- * 
- * TODO: Game splash screen?
- * 
- * @param   tama    The tamagotchi object to be processed
+ * Setup Function
+ * Arduino managed, called only when the device powers on
+ * With a valid save it resumes straight away, so a reset or brown-out doesn't leave the pet waiting on
+ * a button. Holding A and B while powering on brings up the boot prompt instead, as does having no save.
  */
-void rightLeft(tamagotchi& tama) {
-  // Set up the game
-  bool direction = random(0, 2);
-  bool user_guess;
-
-  // Prompt user for input
-  print_f_text(F("Left A"), false, 0, 10);
-  print_f_text(F("Right B"), false, 0, 20);
-  print_f_text(F("Confirm C"), false, 0, 30);
-  while (digitalRead(buttonC) == HIGH) {
-    if (digitalRead(buttonA) == LOW) {
-      user_guess = true;
-      print_f_text(F("GUESS: LEFT"), false, 0, 50);
-    } else if (digitalRead(buttonB) == LOW) {
-      user_guess = false;
-      print_f_text(F("GUESS: RIGHT"), false, 0, 50);
-    }
+void setup() {
+  if (!hal_begin()) {
+    telemetry_event(event_no_rtc);
+    while (1) hal_delay(10);
   }
 
-  if (direction) {
-    // left
-    if (tama.level == 1) {
-      printImage(idle_width, idle_height, level_1_idle_0_bits, true, 90, 0);
-    } else if (tama.level == 2) {
-      printImage(idle_width, idle_height, level_2_idle_0_bits, true, 90, 0);
-    } else if (tama.level == 3) {
-      printImage(idle_width, idle_height, level_3_idle_0_bits, true, 90, 0);
-    } else if (tama.level == 4) {
-      printImage(idle_width, idle_height, level_4_idle_0_bits, true, 90, 0);
-    }
-  } else {
-    // right
-    if (tama.level == 1) {
-      printImage(idle_width, idle_height, level_1_idle_0_bits, true, 0, 0);
-    } else if (tama.level == 2) {
-      printImage(idle_width, idle_height, level_2_idle_0_bits, true, 0, 0);
-    } else if (tama.level == 3) {
-      printImage(idle_width, idle_height, level_3_idle_0_bits, true, 0, 0);
-    } else if (tama.level == 4) {
-      printImage(idle_width, idle_height, level_4_idle_0_bits, true, 0, 0);
-    }
-  }
+#ifdef JIV_RNG_SEED
+  rng_seed(JIV_RNG_SEED);
+#else
+  rng_seed(hal_entropy());
+#endif
+  telemetry_seed(rng_seed_used());
 
-  // Evaluate results
-  if (direction == user_guess ) {
-    print_f_text(F("POGCHAMP"), false, 0, 35);
+  bool chord = hal_pressed(buttonA) && hal_pressed(buttonB);
+  if (!chord && read_eeprom(jiv)) {
+    telemetry_event(event_boot, 2);
   } else {
-    print_f_text(F("Sadge"), false, 0, 35);
+    boot_prompt();
   }
 
-  tama.happy += 5;
-  changed = true;
-  check_bal(tama);
-  print_f_text(F("C to close."), false, 0, 50);
-  while (digitalRead(buttonC) == HIGH) {
-
-  }
+  // Whatever happened while the power was off
+  catchUp(jiv, clock_now());
+  pets_catch_up(clock_now(), active_pet);
+  last_action = clock_now();
 }
 
 /**
- * Healing the sickness of a tamagotchi
- * When a tamagotchi is sick, they will need to be given "medicine" to become healthy again
- * 
- * @param   tama    The tamagotchi object to be processed
+ * Menu
+ * Scroll through the activities with A/B, one entry per press, pick one with C. The picked activity takes
+ * over the action slot.
+ *
+ * @param   act     The running action, ctx is the tamagotchi
  */
-void heal(tamagotchi& tama) {
-  if (!tama.health) {
-    print_f_text(F("Healing..."), true, 10, 40);
-    tama.health = true;
-    delay(4000);
-    print_f_text(F("Healed!"), true, 10, 40);
-    delay(1000);
-  } else {
-    print_f_text(F("Jiv is not sick!"), true, 10, 40);
-    tama.happy -= 10;
-    delay(2000);
-  }
-  check_bal(tama);
-  changed = true;
-  delay(300);
-  print_f_text(F("C to continue"), false, 0, 60);
-  while (digitalRead(buttonC) == HIGH) {
-
-  }
-}
+void menu(action& act) {
+  static uint8_t i;
+
+  switch (act.step) {
+    case 0:
+      i = 0;
+      render(scene_menu, &i);
+      action_wait(act, 0, 1);
+      break;
 
-/**
- * Discipling the tamagotchi
- * When a tamagotchi is misbehaving, they will need to be disciplined 
- * Doing so increases the discipline meter
- * 
- * @param   tama    The tamagotchi object to be processed
- */
-void scold(tamagotchi& tama) {
-  if (tama.misbehave) {
-    print_f_text(F("Scolding..."), true, 10, 40);
-    tama.discipline += 25;
-    tama.happy -= 5;
-    tama.misbehave = false;
-    delay(4000);
-    print_f_text(F("Scolded!"), true, 10, 40);
-    delay(1000);
-  } else {
-    print_f_text(F("Jiv isn't misbehaving"), true, 0, 30);
-    delay(1000);
-    print_f_text(F("... :( ..."), false, 20, 40);
-    tama.happy -= 20;
-  }
-  check_bal(tama);
-  changed = true;
-  delay(300);
-  print_f_text(F("C to continue"), false, 0, 60);
-  while (digitalRead(buttonC) == HIGH) {
+    case 1:
+      switch (input_next_press()) {
+        case buttonB:
+          i = (i == menu_count - 1) ? 0 : i + 1;
+          render(scene_menu, &i);
+          break;
+        case buttonA:
+          i = (i == 0) ? menu_count - 1 : i - 1;
+          render(scene_menu, &i);
+          break;
+        case buttonC:
+          act.step = 2;
+          break;
+        default:
+          action_wait(act, button_poll_ms, 1);
+          break;
+      }
+      break;
 
+    default:
+      clearScreen();
+      last_action = now;
+      telemetry_event(event_action, i);
+      action_start(act, (action_fn)pgm_read_ptr(&menu_entries[i].handler), act.ctx);
+      break;
   }
 }
 
 /**
- * Cleaning excrement
- * When a tamagotchi poops, someone has to be the shit scraper
- * 
- * @param   tama    The tamagotchi object to be processed
+ * Main Loop
+ * Arduino Managed, loops indefinitely after the setup function has completed
+ * Nothing in here blocks except sleeping: the current activity is ticked by the scheduler
+ *
  */
-void clean(tamagotchi& tama) {
-  if (tama.soiled) {
-    print_f_text(F("Cleaning..."), true, 10, 40);
-    tama.happy += 20;
-    tama.soiled = false;
-    delay(2000);
-    print_f_text(F("Cleaned!"), true, 10, 40);
-  } else {
-    print_f_text(F("Jiv didn't poo!"), true, 0, 30);
-  }
-  check_bal(tama);
-  changed = true;
-  delay(300);
-  print_f_text(F("C to continue"), false, 0, 60);
-  while (digitalRead(buttonC) == HIGH) {
-
+void loop() {
+  now = clock_now();
+
+  // A press is activity whatever is on screen, so an open menu or a minigame waiting on a button isn't
+  // cut short by the sleep timeout below
+  static uint32_t edge_seen = 0;
+  uint32_t edge = input_last_edge();
+  if (edge != edge_seen) {
+    edge_seen = edge;
+    last_action = now;
   }
-}
 
-/**
- * Feed Tamagotchi
- * Player can either feed tamagotchi snack or meal
- * Misbehaving tamagotchis will refuse to eat
- * 
- * @param   tama    The tamagotchi object to be fed
- */
-void feed(tamagotchi& tama) {
-  if (tama.misbehave) {
-    print_f_text(F("Jiv refuses to eat!"), true, 10, 10);
-  } else {
-    print_f_text(F("Feed Jiv:"), true, 10, 20);
-    print_f_text(F("A: Meal"), false, 10, 30);
-    print_f_text(F("B: Snack"), false, 10, 40);
-    while (digitalRead(buttonC) == HIGH) {
-      if (digitalRead(buttonA) == LOW) {
-        tama.hunger += 20;
-        tama.snacks_fed = 0;
-        print_f_text(F("Jiv Fed!"), true, 10, 10);
-        break;
-      }
-      if (digitalRead(buttonB) == LOW) {
-        tama.hunger += 10;
-        tama.snacks_fed += 1;
-        tama.happy += 10;
-        print_f_text(F("Jiv Fed"), true, 20, 10);
-        break;
-      }
+  // Level ups and the menu only interrupt the idle animation or the glance screen, never another activity
+  if (!action_busy(ui) || action_running(ui, idle_ani) || action_running(ui, glance)) {
+    if (level_up_due(jiv, now)) {
+      last_action = now;
+      action_start(ui, level_up, &jiv);
+    } else if (input_next_press() == buttonA) {
+      // Coming from the glance screen, the home screen has to be drawn again afterwards
+      changed |= action_running(ui, glance);
+      last_action = now;
+      action_start(ui, menu, &jiv);
     }
   }
-  check_bal(tama);
-  changed = true;
-  delay(300);
-  print_f_text(F("C to continue"), false, 0, 50);
-  while (digitalRead(buttonC) == HIGH) {
 
+  // The contrast steps down as idle time grows, then the glance screen takes over until sleep
+  uint32_t idle_s = now - last_action;
+  if (power_tick(idle_s) == power_glance && action_running(ui, idle_ani)) {
+    action_start(ui, glance, &jiv);
   }
-}
 
-/**
- * Level Up
- * Tamagotchi can only be levelled up when they are in good standing
- * Not soiled, healthy, behaving, >75% hungry, >75% happy
- * 
- * @param   tama    The tamagotchi object to be levelled up
- */
-void level_up(tamagotchi& tama) {
-  if (!jiv.soiled && jiv.health && !jiv.misbehave && (jiv.hunger > 75) && (jiv.happy > 75)) {
-    print_f_text(F("Leveling up....."), true, 20, 40);
-    delay(2000);
-    print_f_text(F("Leveled Up!"), true, 20, 40);
-    tama.level += 1;
-    tama.birth = rtc.now();
-    check_bal(tama);
+  // Pass time every 30 minutes, including any that went by asleep, for the pet on screen and the rest
+  if (catchUp(jiv, now)) {
     changed = true;
-  } else {
-    print_f_text(F("Jiv is not able to be"), true, 0, 30);
-    print_f_text(F("leveled up :("), false, 20, 40);
   }
-
-  print_f_text(F("C to continue"), 0, 50);
-  while (digitalRead(buttonC) == HIGH) {
-
+  pets_catch_up(now, active_pet);
+  
+  if (idle_s > 300) {
+    // Enter low power mode after 5 minutes without a press or a new activity (300s) or if requested
+    // Whatever was on screen is abandoned, the idle animation picks up on wake
+    action_done(ui);
+    sleep_tama = true;
+    doSleep(jiv);
+  } else if (night_sleep && sleep_tama) {
+    doSleep(jiv);
   }
-}
 
-/**
- * Idle Animations
- * Make the tama do a lil dance in the corner lol
- * 
- * @param   tama    The tamagotchi to make dance
- */
-void idle_ani(tamagotchi& tama) {
-  if (tama.level == 1) {
-    printImage(idle_width, idle_height, level_1_idle_0_bits, false);
-    delay(34);
-    printImage(idle_width, idle_height, level_1_idle_1_bits, false);
-    delay(34);
-    printImage(idle_width, idle_height, level_1_idle_2_bits, false);
-    delay(34);
-    printImage(idle_width, idle_height, level_1_idle_3_bits, false);
-    delay(40);
-  } else if (tama.level == 2) {
-    printImage(idle_width, idle_height, level_2_idle_0_bits, false);
-    delay(34);
-    printImage(idle_width, idle_height, level_2_idle_1_bits, false);
-    delay(34);
-    printImage(idle_width, idle_height, level_2_idle_2_bits, false);
-    delay(34);
-    printImage(idle_width, idle_height, level_2_idle_3_bits, false);
-    delay(40);
-  } else if (tama.level == 3) {
-    printImage(idle_width, idle_height, level_3_idle_0_bits, false);
-    delay(34);
-    printImage(idle_width, idle_height, level_3_idle_1_bits, false);
-    delay(34);
-    printImage(idle_width, idle_height, level_3_idle_2_bits, false);
-    delay(34);
-    printImage(idle_width, idle_height, level_3_idle_3_bits, false);
-    delay(40);
-  } else if (tama.level == 4) {
-    printImage(idle_width, idle_height, level_4_idle_0_bits, false);
-    delay(34);
-    printImage(idle_width, idle_height, level_4_idle_1_bits, false);
-    delay(34);
-    printImage(idle_width, idle_height, level_4_idle_2_bits, false);
-    delay(34);
-    printImage(idle_width, idle_height, level_4_idle_3_bits, false);
-    delay(40);
+  action_tick(ui);
+  save_tick(jiv);
+  if (!action_busy(ui)) {
+    action_start(ui, idle_ani, &jiv);
   }
-}
 
-/**
- * Button Interrupt
- * Gets called when the wake button is pressed
- */
-void sleep_wake() {
-  sleep_disable();
-  wdt_disable();
-  sleep_tama = false;
-  detachInterrupt(digitalPinToInterrupt(buttonA));
+  // A staged save writes one EEPROM byte a pass (~3.3 ms), idling until the next frame would drag it out
+  uint32_t due = action_due(ui);
+  if (save_busy() && (int32_t)(due - hal_millis()) > (int32_t)save_yield_ms) {
+    due = hal_millis() + save_yield_ms;
+  }
+  hal_yield_until(due);
 }
 
-/**
- * Sleep Function
- * Puts the arduino into low power mode, so that a potential connected battery doesn't get drained
- */
-void doSleep(tamagotchi& tama) {
-  u8g2.setPowerSave(1);
-	static byte prevADCSRA = ADCSRA;
-	ADCSRA = 0;
-	set_sleep_mode(SLEEP_MODE_PWR_DOWN);
-	sleep_enable();
-
-  while (true) {
-		sleep_bod_disable(); // automatically re-enabled with timer
-		noInterrupts();
-
-		// clear various "reset" flags
-		MCUSR = 0; 	// allow changes, disable reset
-		WDTCSR = bit (WDCE) | bit(WDE); // set interrupt mode and an interval
-		WDTCSR = bit (WDIE) | bit(WDP3) | bit(WDP0); // set WDIE, and 8 second delay https://microcontrollerslab.com/arduino-watchdog-timer-tutorial/
-		wdt_reset();
-    
-    // Configure wake button
-    attachInterrupt(digitalPinToInterrupt(buttonA), sleep_wake, LOW);
-		
-    Serial.flush();
-		interrupts();
-		sleep_cpu();
-
-    if (!sleep_tama) {
-      last_action = rtc.now();
-      break;
-    }
+// The test runner brings its own main()
+#if !defined(ARDUINO) && !defined(PIO_UNIT_TESTING)
 
-    now = rtc.now();
-    if (night_sleep) {
-      if ((now.unixtime() - then.unixtime()) > 32400) {
-        // Sleep through the night (9 hours, 32400 seconds)
-        sleep_tama = false;
-        night_sleep = false;
-      }
-    } else {
-      if (now.unixtime() - then.unixtime() > 1800) {
-        // Pass time every 30 minutes (1800s)
-        passTime(tama);
-        write_eeprom(tama, false);
-        changed = true;
-        then = now;
-      }
-    }
-	}
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "bench.h"
+#include "sim.h"
 
-	sleep_disable();
-	ADCSRA = prevADCSRA;
-  u8g2.setPowerSave(0);
-}
+static uint32_t owner_returns_ms = 0;
 
 /**
- * Setup Function
- * Arduino managed, called only when the device powers on
+ * Native Input Script
+ * Starts a new tama at the boot prompt, leaves it alone, and comes back to wake it once the run is over
  */
-void setup() {
-  Serial.begin(9600);
-
-  randomSeed(analogRead(A0));
-
-  u8g2.begin();
-  u8g2.clear();
-  u8g2.clearBuffer();
-
-  if (! rtc.begin()) {
-  Serial.println(F("Couldn't find RTC"));
-  Serial.flush();
-  while (1) delay(10);
-  }
-
-  pinMode(buttonA, INPUT_PULLUP);
-  pinMode(buttonB, INPUT_PULLUP);
-  pinMode(buttonC, INPUT_PULLUP);
-
-  u8g2.setFont(u8g2_font_ncenB08_tr);
-  print_f_text(F("A: Load Saved Tama"), true, 10, 10);
-  print_f_text(F("B: New Tama"), false, 10, 20);
-  while (true) {
-    if (digitalRead(buttonA) == LOW) {
-      read_eeprom(jiv);
-      break;
-    } else if (digitalRead(buttonB) == LOW) {
-      jiv.birth = rtc.now();
-      break;
-    }
+bool native_input(uint8_t pin, uint32_t ms) {
+  if (ms < 1000) {
+    return pin == buttonB;
   }
-  clearScreen();
-
-  then = rtc.now();
-  last_action = rtc.now();
+  return (ms >= owner_returns_ms) && ((pin == buttonA) || (pin == buttonC));
 }
 
 /**
- * Main Loop
- * Arduino Managed, loops indefinitely after the setup function has completed
+ * Native Entry Point
+ * Runs setup() and then loop() until the requested amount of virtual time has passed, or the rendering
+ * or pet benchmark (bench.h), or the balance simulator (sim.h). Telemetry frames (telemetry.h) go to telemetry_file if one is given.
  *
+ * Usage: program [hours] [seed] [telemetry_file]
+ *        program bench [rounds] [capture_dir]
+ *        program pets [rounds]
+ *        program sim [lifetimes] [threads] [seed]
  */
-void loop() {
-  now = rtc.now();
-
-  if (((now.unixtime() - jiv.birth.unixtime()) > 18000) && (jiv.level == 1) && !jiv.soiled && jiv.health && !jiv.misbehave && (jiv.hunger > 75) && (jiv.happy > 75)) {
-    // Level 1 -> Level 2, 5 Hours
-    level_up(jiv);
-  } else if (((now.unixtime() - jiv.birth.unixtime()) > 86400) && (jiv.level == 2) && !jiv.soiled && jiv.health && !jiv.misbehave && (jiv.hunger > 75) && (jiv.happy > 75)) {
-    // Level 2 -> Level 3, 1 Day
-    level_up(jiv);
-  } else if (((now.unixtime() - jiv.birth.unixtime()) > 172800) && (jiv.level == 3) && !jiv.soiled && jiv.health && !jiv.misbehave && (jiv.hunger > 75) && (jiv.happy > 75)) {
-    // Level 3 -> Level 4, 2 Days
-    level_up(jiv);
-  }
-
-  if (digitalRead(buttonA) == LOW) {
-    delay(500);
-    int i = 0;
-    printText(activities[i], true, 25, 25);
-    while (digitalRead(buttonC) == HIGH) {
-      if (digitalRead(buttonB) == LOW) {
-        if (i == 6) {
-          i = 0;
-        } else {
-          i++;
-        }
-        printText(activities[i], true, 25, 25);
-        delay(500);
-      } else if (digitalRead(buttonA) == LOW) {
-        if (i == 0) {
-          i = 6;
-        } else {
-          i--;
-        }
-        printText(activities[i], true, 25, 25);
-        delay(500);
-      }
+int main(int argc, char **argv) {
+  if (argc > 1 && strcmp(argv[1], "bench") == 0) {
+    unsigned long rounds = (argc > 2) ? strtoul(argv[2], NULL, 10) : 1000;
+    return bench_run(rounds > 0 ? rounds : 1, (argc > 3) ? argv[3] : NULL);
+  }
+  if (argc > 1 && strcmp(argv[1], "pets") == 0) {
+    unsigned long rounds = (argc > 2) ? strtoul(argv[2], NULL, 10) : 1000000;
+    return bench_pets(rounds > 0 ? rounds : 1);
+  }
+  if (argc > 1 && strcmp(argv[1], "sim") == 0) {
+    unsigned long lifetimes = (argc > 2) ? strtoul(argv[2], NULL, 10) : 100000;
+    unsigned threads = (argc > 3) ? strtoul(argv[3], NULL, 10) : 0;
+    return sim_run(lifetimes, threads, (argc > 4) ? strtoul(argv[4], NULL, 10) : 0);
+  }
+
+  unsigned long hours = (argc > 1) ? strtoul(argv[1], NULL, 10) : 24;
+  unsigned long seed = (argc > 2) ? strtoul(argv[2], NULL, 10) : 0;
+  FILE *telemetry = NULL;
+  if (argc > 3) {
+    telemetry = fopen(argv[3], "wb");
+    if (telemetry == NULL) {
+      perror(argv[3]);
+      return 1;
     }
-    switch(i) {
-      case 0:
-        over_under = true;
-        break;
-      case 1:
-        right_left = true;
-        break;
-      case 2:
-        heal_tama = true;
-        break;
-      case 3:
-        scold_tama = true;
-        break;
-      case 4:
-        clean_tama = true;
-        break;
-      case 5:
-        feed_tama = true;
-        break;
-      case 6:
-        sleep_tama = true;
-        night_sleep = true;
-        break;
-    }
-    clearScreen();
-    last_action = now;
-  }
-
-  if ((now.unixtime() - then.unixtime()) > 1800) {
-    // Pass time every 30 minutes
-    passTime(jiv);
-    then = now;
   }
-  
-  if ((now.unixtime() - last_action.unixtime()) > 300) {
-    // Enter low power mode after 5 idle minutes (300s) or if requested
-    sleep_tama = true;
-    doSleep(jiv);
-    now = rtc.now();
-  }
-
-  if (over_under) {
-    overUnder(jiv);
-    over_under = false;
-  } else if (right_left) {
-    rightLeft(jiv);
-    right_left = false;
-  } else if (heal_tama) {
-    heal(jiv);
-    heal_tama = false;
-  } else if (scold_tama) {
-    scold(jiv);
-    scold_tama = false;
-  } else if (clean_tama) {
-    clean(jiv);
-    clean_tama = false;
-  } else if (feed_tama) {
-    feed(jiv);
-    feed_tama = false;
-  } else if (night_sleep && sleep_tama) {
-    doSleep(jiv);
-    now = rtc.now();
-  } else {
-    idle_ani(jiv);
 
-    if (changed) {
-      write_eeprom(jiv);
-      print_stats(jiv);
-      changed = false;
-      jiv.print();
-    }
-  }
+  owner_returns_ms = hours * 3600000UL;
+  hal_native_set_input(native_input);
+  hal_native_set_serial(telemetry);
+  hal_native_set_entropy(seed);
+  setup();
+
+  unsigned long iterations = 0;
+  clock_t start = clock();
+  while (hal_millis() < owner_returns_ms) {
+    loop();
+    iterations++;
+  }
+  // The owner is back, one more pass catches up the time spent asleep
+  loop();
+  iterations++;
+  double elapsed = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+  if (telemetry != NULL) {
+    fclose(telemetry);
+  }
+
+  printf("Happy: %u\nHunger: %u\nHealth: %u\nDiscipline: %u\nLevel: %u\nSoiled: %u\nBirthday: %lu\n",
+         jiv.happy, jiv.hunger, jiv.health, jiv.discipline, jiv.level, jiv.soiled, (unsigned long)jiv.birth);
+  printf("Seed: %lu\n", (unsigned long)rng_seed_used());
+  printf("\n%lu virtual hours, %lu loop iterations, %.3f s host time (%.2f us/iteration)\n",
+         hours, iterations, elapsed, iterations ? elapsed * 1e6 / iterations : 0.0);
+  printf("%lu bytes sent to the display\n", (unsigned long)display_total_bytes());
+  const display_totals& frames = display_total();
+  printf("%lu frames, %.1f lit pixels each\n", (unsigned long)frames.frames,
+         frames.frames ? (double)frames.lit_pixels / frames.frames : 0.0);
+  printf("last sleep: %u wakes, %u I2C transactions\n", last_sleep.wakes, last_sleep.i2c);
+  printf("telemetry frames dropped: %u\n", telemetry_dropped());
+  return 0;
 }
 
-/**
- * Interrupts
- */
-
-// When WatchDog timer causes µC to wake it comes here
-ISR (WDT_vect) {
-	// Turn off watchdog, we don't want it to do anything (like resetting this sketch)
-	wdt_disable();
-}
\ No newline at end of file
+#endif
@@ -0,0 +1,67 @@
+/*
+ * Jiva-gotchi: Pets
+*/
+
+#include "pets.h"
+
+pet_store pets;
+uint8_t active_pet = 0;
+
+bool pets_get(uint8_t slot, tamagotchi& tama) {
+  uint8_t mask = 1 << slot;
+  if ((pets.used & mask) == 0) {
+    return false;
+  }
+  tama.birth = pets.birth[slot];
+  tama.ticked = pets.ticked[slot];
+  tama.hunger = pets.hunger[slot];
+  tama.happy = pets.happy[slot];
+  tama.discipline = pets.discipline[slot];
+  tama.level = pets.level[slot];
+  tama.snacks_fed = pets.snacks_fed[slot];
+  tama.health = (pets.health & mask) != 0;
+  tama.soiled = (pets.soiled & mask) != 0;
+  tama.misbehave = (pets.misbehave & mask) != 0;
+  return true;
+}
+
+/**
+ * Set Bit
+ * Sets or clears one pet's bit in a flag byte
+ */
+static void set_bit(uint8_t& flags, uint8_t mask, bool value) {
+  flags = value ? (flags | mask) : (flags & ~mask);
+}
+
+void pets_put(uint8_t slot, const tamagotchi& tama) {
+  uint8_t mask = 1 << slot;
+  pets.birth[slot] = tama.birth;
+  pets.ticked[slot] = tama.ticked;
+  pets.hunger[slot] = tama.hunger;
+  pets.happy[slot] = tama.happy;
+  pets.discipline[slot] = tama.discipline;
+  pets.level[slot] = tama.level;
+  pets.snacks_fed[slot] = tama.snacks_fed;
+  set_bit(pets.health, mask, tama.health);
+  set_bit(pets.soiled, mask, tama.soiled);
+  set_bit(pets.misbehave, mask, tama.misbehave);
+  pets.used |= mask;
+}
+
+uint8_t pets_catch_up(uint32_t time, uint8_t skip) {
+  uint8_t passed = 0;
+  uint8_t left = pets.used;
+  for (uint8_t slot = 0; left != 0; slot++, left >>= 1) {
+    // Nearly every pass ends here, after one subtraction per pet
+    if (!(left & 1) || (int32_t)(time - pets.ticked[slot]) < (int32_t)tick_interval || slot == skip) {
+      continue;
+    }
+    tamagotchi tama;
+    pets_get(slot, tama);
+    catchUp(tama, time);
+    pets_put(slot, tama);
+    passed |= 1 << slot;
+  }
+  pets.dirty |= passed;
+  return passed;
+}
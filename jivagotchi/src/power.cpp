@@ -0,0 +1,39 @@
+/*
+ * Jiva-gotchi: Display Power
+*/
+
+#include "power.h"
+
+/**
+ * Stages
+ * Full is the contrast the SH1106 init sequence sets; each step down roughly halves the panel current
+ */
+struct power_step {
+  uint16_t idle_s;
+  uint8_t contrast;
+};
+
+static const power_step steps[] PROGMEM = {
+  { 0, 0xCF },
+  { JIV_GLANCE_S / 3, 0x60 },
+  { JIV_GLANCE_S * 2 / 3, 0x20 },
+  { JIV_GLANCE_S, 0x08 }
+};
+
+static uint8_t stage = power_full;
+
+uint8_t power_tick(uint32_t idle_s) {
+  uint8_t next = power_glance;
+  while (next > power_full && idle_s < pgm_read_word(&steps[next].idle_s)) {
+    next--;
+  }
+  if (next != stage) {
+    stage = next;
+    hal_display_contrast(pgm_read_byte(&steps[stage].contrast));
+  }
+  return stage;
+}
+
+uint8_t power_stage() {
+  return stage;
+}
@@ -0,0 +1,58 @@
+/*
+ * Jiva-gotchi: Random Numbers
+*/
+
+#include "rng.h"
+
+#ifdef ARDUINO
+static uint32_t state;
+static uint32_t seeded;
+#else
+static thread_local uint32_t state;
+static thread_local uint32_t seeded;
+#endif
+
+void rng_seed(uint32_t seed) {
+  seeded = seed;
+  // Scramble the seed so that neighbouring seeds don't start on neighbouring states.
+  // The scrambling is reversible, so only one seed lands on 0, which xorshift can't leave
+  uint32_t x = seed + 0x9E3779B9UL;
+  x ^= x >> 16;
+  x *= 0x85EBCA6BUL;
+  x ^= x >> 13;
+  x *= 0xC2B2AE35UL;
+  x ^= x >> 16;
+  state = (x != 0) ? x : 0x9E3779B9UL;
+}
+
+uint32_t rng_seed_used() {
+  return seeded;
+}
+
+uint32_t rng_next() {
+  if (state == 0) {
+    rng_seed(0);
+  }
+  uint32_t x = state;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  state = x;
+  return x;
+}
+
+uint16_t rng_u16() {
+  // The low bits of xorshift are its weakest
+  return rng_next() >> 16;
+}
+
+uint16_t rng_below(uint16_t n) {
+  return ((uint32_t)rng_u16() * n) >> 16;
+}
+
+int16_t rng_range(int16_t min, int16_t max) {
+  if (min >= max) {
+    return min;
+  }
+  return min + rng_below(max - min);
+}
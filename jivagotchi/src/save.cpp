@@ -0,0 +1,540 @@
+/*
+ * Jiva-gotchi: Saving
+ * Two tiers. The pet on screen changes with every action, and each change goes to the RTC's battery
+ * backed NVRAM within a second: no wear, one short I2C write. The EEPROM save journal (journal.h), with
+ * a run of slots for each pet, only gets checkpoints: on level-up, once changes have waited
+ * JIV_SAVE_INTERVAL_S, and when switching pets. The other pets only change when time passes for them, the
+ * store marks them dirty and they go straight to the journal.
+ *
+ * The NVRAM holds two copies of the hot record, written in turn, so one cut short leaves the other. Each
+ * names the journal sequence number of the checkpoint it was written after (counting one still being
+ * written); loading takes it over the journal unless a newer checkpoint has been written since. What was
+ * last written to either tier is kept in RAM, so telling which fields are dirty is a comparison rather
+ * than a read.
+ *
+ * A record is a schema version byte followed by the tamagotchi. Each version has its own record length,
+ * and the journal CRC covers the length, so a journal opened for one version never accepts another's
+ * records. Older layouts are migrated once when loading and saved again in the current one.
+*/
+
+#include "game.h"
+#include "pets.h"
+#include "journal.h"
+#include "clock.h"
+#include "telemetry.h"
+
+#ifdef ARDUINO
+#include <util/crc16.h>
+#endif
+
+// How many EEPROM bytes one pass of save_tick() may write, each one costs ~3.3 ms
+static const uint8_t save_bytes_per_tick = 1;
+static const uint32_t save_interval_ms = JIV_SAVE_INTERVAL_S * 1000UL;
+
+/**
+ * Schema versions
+ * 0: the unpacked class, ints and RTClib's DateTime, as EEPROM.put() wrote it. Found either at address 0
+ *    (before the journal) or as an unversioned journal record.
+ * 1: version byte + the packed tamagotchi, without ticked
+ * 2: version byte + the packed tamagotchi
+ * 3: version byte + pet slot + the packed tamagotchi, in that pet's run of slots
+ */
+static const uint8_t save_version = 3;
+static const uint8_t record_size = 2 + sizeof(tamagotchi);
+static const uint8_t record_size_v2 = 1 + sizeof(tamagotchi);
+
+struct tamagotchi_v0 {
+  int16_t hunger;
+  int16_t happy;
+  int16_t discipline;
+  int16_t level;
+  bool health;
+  bool soiled;
+  bool misbehave;
+  int16_t snacks_fed;
+  // RTClib DateTime: years since 2000, month, day, hour, minute, second
+  uint8_t birth[6];
+} __attribute__((packed));
+
+struct tamagotchi_v1 {
+  uint32_t birth;
+  uint8_t hunger;
+  uint8_t happy;
+  uint8_t discipline;
+  uint8_t level;
+  uint8_t snacks_fed;
+  bool health : 1;
+  bool soiled : 1;
+  bool misbehave : 1;
+};
+
+static_assert(record_size <= journal_payload_size, "tamagotchi doesn't fit a journal slot");
+static_assert(sizeof(tamagotchi_v0) <= journal_payload_size, "v0 record doesn't fit a journal slot");
+static_assert(1 + sizeof(tamagotchi_v1) < record_size_v2, "v1 and v2 records can't share a length");
+
+// Up to version 2 the whole EEPROM was one save journal, now every pet has an equal share of it
+static const uint8_t legacy_slots = journal_eeprom_size / journal_slot_size;
+static const uint8_t pet_slots = legacy_slots / pets_max;
+static_assert(pet_slots >= 2, "every pet needs two journal slots, so a cut short save falls back");
+
+// One journal at a time, opened for whichever pet is being saved
+static journal saves;
+static uint8_t saves_pet = pet_none;
+
+// The active pet's next journal sequence number, kept while another pet's journal is open
+static uint8_t seq_pet = pet_none;
+static uint16_t seq_next = 0;
+
+/**
+ * Hot record
+ * In the RTC NVRAM, packed so two fit with room to spare on the host too
+ */
+static const uint8_t hot_version = 1;
+static const uint32_t hot_interval_ms = 1000;
+
+struct hot_record {
+  uint8_t version;
+  uint8_t pet;
+  uint16_t checkpoint;  // journal sequence number it is newer than
+  uint8_t count;        // which of the two copies is newer
+  uint8_t tama[sizeof(tamagotchi)];
+  uint16_t crc;
+} __attribute__((packed));
+
+static_assert(2 * sizeof(hot_record) <= hal_nvram_size, "two hot records don't fit the NVRAM");
+static_assert(sizeof(hot_record) <= 31, "a hot record doesn't fit one NVRAM write");
+
+static bool hot_opened = false;
+static uint8_t hot_count = 0;
+static uint32_t hot_written = 0;
+
+static tamagotchi saved;
+static tamagotchi checkpointed;
+static bool dirty_waiting = false;
+static uint32_t dirty_since = 0;
+static bool flush_requested = false;
+
+/**
+ * Open a pet's save journal, finishing the record still staged in the one open before
+ */
+static void open_saves(uint8_t pet) {
+  if (saves_pet != pet) {
+    if (saves_pet == active_pet || saves_pet == seq_pet) {
+      seq_pet = saves_pet;
+      seq_next = journal_next_seq(saves);
+    }
+    while (journal_pending(saves)) {
+      journal_step(saves, journal_slot_size);
+    }
+    journal_open(saves, pet * pet_slots * journal_slot_size, pet_slots, record_size);
+    saves_pet = pet;
+  }
+}
+
+/**
+ * Pack
+ * Prefix the tama with the schema version and its slot
+ */
+static void pack(uint8_t pet, const tamagotchi& tama, uint8_t *record) {
+  record[0] = save_version;
+  record[1] = pet;
+  memcpy(record + 2, &tama, sizeof(tamagotchi));
+}
+
+/**
+ * Write / Stage
+ * A pet's record, right away or a few bytes per save_tick()
+ */
+static void write_pet(uint8_t pet, const tamagotchi& tama) {
+  uint8_t record[record_size];
+  pack(pet, tama, record);
+  open_saves(pet);
+  journal_write(saves, record, record_size);
+}
+
+static void stage_pet(uint8_t pet, const tamagotchi& tama) {
+  uint8_t record[record_size];
+  pack(pet, tama, record);
+  open_saves(pet);
+  journal_stage(saves, record, record_size);
+}
+
+/**
+ * Checkpointed
+ * The tama is now what's in the journal (or about to be)
+ */
+static void mark_checkpointed(const tamagotchi& tama) {
+  checkpointed = tama;
+  dirty_waiting = false;
+  flush_requested = false;
+}
+
+/**
+ * Hot Read
+ * The newer of the two NVRAM copies that checks out
+ *
+ * @return  False if neither does
+ */
+static uint16_t hot_crc(const hot_record& record) {
+  const uint8_t *bytes = (const uint8_t *)&record;
+  uint16_t crc = 0xFFFF;
+  for (uint8_t i = 0; i < sizeof(hot_record) - sizeof(record.crc); i++) {
+    crc = _crc_ccitt_update(crc, bytes[i]);
+  }
+  return crc;
+}
+
+static bool hot_read(hot_record& newest) {
+  bool found = false;
+  for (uint8_t copy = 0; copy < 2; copy++) {
+    hot_record record;
+    hal_nvram_read(copy * sizeof(hot_record), &record, sizeof(record));
+    if (record.version != hot_version || record.pet >= pets_max || record.crc != hot_crc(record)) {
+      continue;
+    }
+    if (!found || (int8_t)(record.count - newest.count) > 0) {
+      newest = record;
+      found = true;
+    }
+  }
+  hot_opened = true;
+  hot_count = found ? newest.count : 0;
+  return found;
+}
+
+/**
+ * Active Sequence Number
+ * From the open journal if it is the active pet's, else as it was when that one was last open, so a
+ * record staged for another pet keeps going out a byte at a time. Only a pet never opened since it
+ * became active has its journal opened for this.
+ */
+static uint16_t active_seq() {
+  if (saves_pet != active_pet && seq_pet != active_pet) {
+    open_saves(active_pet);
+  }
+  if (saves_pet == active_pet) {
+    seq_pet = active_pet;
+    seq_next = journal_next_seq(saves);
+  }
+  return seq_next;
+}
+
+/**
+ * Active Sequence Number Ready
+ * Whether active_seq() can answer without finishing another pet's staged record first
+ */
+static bool active_seq_ready() {
+  return saves_pet == active_pet || seq_pet == active_pet || !journal_pending(saves);
+}
+
+/**
+ * Hot Write
+ * Over the older copy
+ */
+static void hot_write(const tamagotchi& tama) {
+  hot_record record;
+  if (!hot_opened) {
+    hot_read(record);
+  }
+  record.version = hot_version;
+  record.pet = active_pet;
+  record.checkpoint = active_seq();
+  record.count = ++hot_count;
+  memcpy(record.tama, &tama, sizeof(tamagotchi));
+  record.crc = hot_crc(record);
+  hal_nvram_write((record.count & 1) * sizeof(hot_record), &record, sizeof(record));
+  saved = tama;
+  hot_written = hal_millis();
+}
+
+/**
+ * Migrate
+ * Older versions to the current layout, clamping everything back into range. Older saves don't say when
+ * time last passed, so no time passes for the gap before they were loaded.
+ */
+static int clamp(int value, int low, int high) {
+  return (value < low) ? low : (value > high) ? high : value;
+}
+
+static void migrate_v0(const tamagotchi_v0& old, tamagotchi& tama) {
+  tama.hunger = clamp(old.hunger, 0, stat_max);
+  tama.happy = clamp(old.happy, 0, stat_max);
+  tama.discipline = clamp(old.discipline, 0, stat_max);
+  tama.level = clamp(old.level, 1, level_max);
+  tama.snacks_fed = clamp(old.snacks_fed, 0, 255);
+  tama.health = old.health;
+  tama.soiled = old.soiled;
+  tama.misbehave = old.misbehave;
+  tama.birth = DateTime(2000 + old.birth[0], old.birth[1], old.birth[2], old.birth[3], old.birth[4], old.birth[5]).unixtime();
+  tama.ticked = clock_now();
+}
+
+static void migrate_v1(const tamagotchi_v1& old, tamagotchi& tama) {
+  tama.birth = old.birth;
+  tama.ticked = clock_now();
+  tama.hunger = old.hunger;
+  tama.happy = old.happy;
+  tama.discipline = old.discipline;
+  tama.level = old.level;
+  tama.snacks_fed = old.snacks_fed;
+  tama.health = old.health;
+  tama.soiled = old.soiled;
+  tama.misbehave = old.misbehave;
+}
+
+/**
+ * Load
+ * The newest current record in the pet's slots
+ *
+ * @return  False if it has none
+ */
+static bool load(uint8_t pet, tamagotchi& tama) {
+  uint8_t record[record_size];
+  open_saves(pet);
+  if (journal_read(saves, record, record_size) && record[0] == save_version && record[1] == pet) {
+    memcpy(&tama, record + 2, sizeof(tamagotchi));
+    return true;
+  }
+  return false;
+}
+
+/**
+ * Plausible
+ * The raw version 0 save has no CRC, so it only counts if every field is in range. Erased EEPROM (0xFF)
+ * and the journal's slots never are.
+ */
+static bool plausible_v0(const tamagotchi_v0& old) {
+  return old.hunger >= 0 && old.hunger <= stat_max && old.happy >= 0 && old.happy <= stat_max &&
+         old.discipline >= 0 && old.discipline <= stat_max && old.level >= 1 && old.level <= level_max &&
+         old.birth[1] >= 1 && old.birth[1] <= 12 && old.birth[2] >= 1 && old.birth[2] <= 31;
+}
+
+/**
+ * Load Legacy
+ * From before there were several pets: the newest version 2 or 1 record in the whole EEPROM, else the
+ * version 0 save at address 0. Only ever the first pet, with its journal open.
+ *
+ * @return  False if there is none, the tama is left alone
+ */
+static bool load_legacy(tamagotchi& tama) {
+  journal old_saves;
+  uint8_t old_record[record_size_v2];
+  journal_open(old_saves, 0, legacy_slots, record_size_v2);
+  if (journal_read(old_saves, old_record, record_size_v2) && old_record[0] == 2) {
+    memcpy(&tama, old_record + 1, sizeof(tamagotchi));
+  } else {
+    journal_open(old_saves, 0, legacy_slots, 1 + sizeof(tamagotchi_v1));
+    if (journal_read(old_saves, old_record, 1 + sizeof(tamagotchi_v1)) && old_record[0] == 1) {
+      tamagotchi_v1 old;
+      memcpy(&old, old_record + 1, sizeof(old));
+      migrate_v1(old, tama);
+    } else {
+      tamagotchi_v0 old;
+      journal_open(old_saves, 0, legacy_slots, sizeof(tamagotchi_v0));
+      if (!journal_read(old_saves, &old, sizeof(old))) {
+        hal_storage_get(0, old);
+        if (!plausible_v0(old)) {
+          return false;
+        }
+      }
+      migrate_v0(old, tama);
+    }
+  }
+
+  if (old_saves.valid && old_saves.newest < saves.slots) {
+    // Carry on after the old records, so the newest of them is the last to be overwritten
+    saves.newest = old_saves.newest;
+    saves.seq = old_saves.seq;
+  }
+  return true;
+}
+
+/**
+ * Changed Fields
+ * The save_field bits where the two differ
+ */
+static uint16_t changed_fields(const tamagotchi& tama, const tamagotchi& saved) {
+  uint16_t dirty = 0;
+  if (tama.hunger != saved.hunger) dirty |= save_hunger;
+  if (tama.happy != saved.happy) dirty |= save_happy;
+  if (tama.discipline != saved.discipline) dirty |= save_discipline;
+  if (tama.level != saved.level) dirty |= save_level;
+  if (tama.health != saved.health) dirty |= save_health;
+  if (tama.soiled != saved.soiled) dirty |= save_soiled;
+  if (tama.misbehave != saved.misbehave) dirty |= save_misbehave;
+  if (tama.snacks_fed != saved.snacks_fed) dirty |= save_snacks_fed;
+  if (tama.birth != saved.birth) dirty |= save_birth;
+  if (tama.ticked != saved.ticked) dirty |= save_ticked;
+  return dirty;
+}
+
+uint16_t save_dirty(const tamagotchi& tama) {
+  return changed_fields(tama, saved);
+}
+
+void save_soon() {
+  flush_requested = true;
+}
+
+void save_switched(const tamagotchi& tama, bool behind) {
+  mark_checkpointed(tama);
+  flush_requested = behind;
+}
+
+bool save_busy() {
+  return journal_pending(saves);
+}
+
+/**
+ * Stage Stored
+ * The first other pet that time passed for. That happens at most every 30 minutes a pet, so they don't
+ * wait out the interval.
+ */
+static void stage_stored() {
+  uint8_t waiting = pets.dirty & ~(1 << active_pet);
+  for (uint8_t pet = 0; waiting != 0; pet++, waiting >>= 1) {
+    if (waiting & 1) {
+      tamagotchi tama;
+      pets_get(pet, tama);
+      stage_pet(pet, tama);
+      pets.dirty &= ~(1 << pet);
+      return;
+    }
+  }
+}
+
+void save_tick(tamagotchi& tama) {
+  // Every change is in the NVRAM within a second, a burst of them in one write. Right after switching pets
+  // that waits for a record staged in another pet's journal to go out.
+  if (save_dirty(tama) != 0 && (hal_millis() - hot_written) >= hot_interval_ms && active_seq_ready()) {
+    hot_write(tama);
+  }
+
+  if (journal_pending(saves)) {
+    journal_step(saves, save_bytes_per_tick);
+    return;
+  }
+
+  uint16_t behind = changed_fields(tama, checkpointed);
+  if (behind == 0 && !flush_requested) {
+    dirty_waiting = false;
+    stage_stored();
+    return;
+  }
+  if (!dirty_waiting) {
+    dirty_waiting = true;
+    dirty_since = hal_millis();
+  }
+
+  // Changes coalesce until the interval is up, then the whole tama is checkpointed in one record
+  if (flush_requested || (hal_millis() - dirty_since) >= save_interval_ms) {
+    telemetry_event(event_save, behind);
+    stage_pet(active_pet, tama);
+    mark_checkpointed(tama);
+  } else {
+    stage_stored();
+  }
+}
+
+void save_now(tamagotchi& tama) {
+  if (save_dirty(tama) != 0) {
+    hot_write(tama);
+  }
+}
+
+/**
+ * Write tama stats to EEPROM
+ * Checkpoints the active pet to its save journal, so consecutive saves land in different cells, and
+ * writes the NVRAM copy after it. Blocks until the record is written, including a write-behind save that
+ * was still going.
+ * 
+ * @param   tama    The tama to be saved
+ */
+void write_eeprom(tamagotchi& tama) {
+  write_pet(active_pet, tama);
+  mark_checkpointed(tama);
+  hot_write(tama);
+}
+
+void save_pets() {
+  for (uint8_t pet = 0; pet < pets_max; pet++) {
+    if (pet != active_pet && (pets.dirty & (1 << pet))) {
+      tamagotchi tama;
+      pets_get(pet, tama);
+      write_pet(pet, tama);
+    }
+  }
+  pets.dirty &= 1 << active_pet;
+}
+
+/**
+ * Read tama stats from EEPROM
+ * The pet in the NVRAM copy is the one that was on screen, so it is active again. Takes its newest
+ * checkpoint, or at power on, when that's the first pet and it has none, migrates the one from an older
+ * layout; then the NVRAM copy if it is newer. The other pets that have a save go into the store.
+ * Only records that pass their CRC and version check count, so this is also how boot tells whether
+ * there is anything to resume. A few ms of EEPROM and I2C reads, nothing is drawn.
+ * 
+ * @param   tama    The tama to be read into
+ * @return  False if there is no valid save, the tama is left alone
+ */
+bool read_eeprom(tamagotchi& tama) {
+  hot_record hot;
+  bool have_hot = hot_read(hot);
+  if (have_hot) {
+    active_pet = hot.pet;
+  }
+
+  bool found = load(active_pet, tama);
+  if (!found && active_pet == 0 && load_legacy(tama)) {
+    write_pet(active_pet, tama);
+    found = true;
+  }
+  if (found) {
+    mark_checkpointed(tama);
+    saved = tama;
+  }
+  // Newer unless a checkpoint was finished after it
+  if (have_hot && (!saves.valid || (int16_t)(hot.checkpoint - saves.seq) >= 0)) {
+    memcpy(&tama, hot.tama, sizeof(tamagotchi));
+    saved = tama;
+    found = true;
+  }
+  if (!found) {
+    return false;
+  }
+  pets_put(active_pet, tama);
+  read_pets();
+  telemetry_state(tama);
+  return true;
+}
+
+/**
+ * Checkpoint Hot
+ * Before the boot prompt: the pet in the NVRAM copy is the one that was on screen, so it is the one a new
+ * tama replaces. If the copy is newer than that pet's journal it goes into the journal first, as the next
+ * NVRAM writes overwrite it.
+ */
+void checkpoint_hot() {
+  hot_record hot;
+  if (!hot_read(hot)) {
+    return;
+  }
+  active_pet = hot.pet;
+  open_saves(active_pet);
+  if (!saves.valid || (int16_t)(hot.checkpoint - saves.seq) >= 0) {
+    tamagotchi tama;
+    memcpy(&tama, hot.tama, sizeof(tamagotchi));
+    write_pet(active_pet, tama);
+    mark_checkpointed(tama);
+  }
+}
+
+void read_pets() {
+  for (uint8_t pet = 0; pet < pets_max; pet++) {
+    tamagotchi tama;
+    if (pet != active_pet && load(pet, tama)) {
+      pets_put(pet, tama);
+    }
+  }
+}
@@ -0,0 +1,67 @@
+/*
+ * Jiva-gotchi: Cooperative Scheduler
+*/
+
+#include "scheduler.h"
+
+void action_start(action& act, action_fn run, void *ctx) {
+  act.run = run;
+  act.ctx = ctx;
+  act.step = 0;
+  act.button = 0;
+  act.due = hal_millis();
+}
+
+void action_wait(action& act, uint32_t ms, uint8_t next_step) {
+  act.step = next_step;
+  act.button = 0;
+  act.due = hal_millis() + ms;
+}
+
+void action_wait_button(action& act, uint8_t button, uint8_t next_step) {
+  act.step = next_step;
+  act.button = button;
+  act.due = hal_millis();
+  input_flush();
+}
+
+void action_done(action& act) {
+  act.run = NULL;
+}
+
+bool action_tick(action& act) {
+  if (act.run == NULL) {
+    return false;
+  }
+
+  uint32_t ms = hal_millis();
+  if ((int32_t)(ms - act.due) < 0) {
+    return false;
+  }
+  if (act.button != 0) {
+    uint8_t pressed;
+    do {
+      pressed = input_next_press();
+    } while (pressed != 0 && pressed != act.button);
+    if (pressed == 0) {
+      act.due = ms + button_poll_ms;
+      return false;
+    }
+    act.button = 0;
+  }
+
+  act.run(act);
+  return true;
+}
+
+bool action_busy(const action& act) {
+  return act.run != NULL;
+}
+
+bool action_running(const action& act, action_fn run) {
+  return act.run == run;
+}
+
+uint32_t action_due(const action& act) {
+  return act.due;
+}
@@ -0,0 +1,241 @@
+/*
+ * Jiva-gotchi: Balance Simulator
+ * A lifetime starts with a new tama at 08:00 and lasts sim_days. The owner checks in every so often
+ * between 08:00 and 23:00: time is caught up, the tama is looked at (that's what the stats below are
+ * taken from), then cared for the way the owner does it, and a level up happens if one is due, like
+ * loop() would while someone is there. At 23:00 an owner who tucks it in starts the night's sleep,
+ * otherwise it is left awake until the morning.
+ *
+ * Each worker thread has its own tallies and random sequence (rng.h is per thread on the host),
+ * they are only added up once every thread is done.
+*/
+
+#ifndef ARDUINO
+
+#include "sim.h"
+#include "game.h"
+#include "rng.h"
+#include <stdio.h>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+/**
+ * Owners
+ * How the scripted players look after their tama
+ */
+struct owner {
+  const char *name;
+  uint32_t every;       // seconds between check-ins
+  bool tucks_in;        // puts it to sleep for the night at 23:00
+  bool snacks;          // feeds snacks instead of meals
+  uint8_t feed_below;   // feeds it when hunger is below this
+  uint8_t play_below;   // plays a minigame when happy is below this
+};
+
+static const owner owners[] = {
+  {"attentive", 1800, true, false, 80, 80},
+  {"casual", 4 * 3600UL, true, false, 80, 80},
+  {"snacker", 2 * 3600UL, true, true, 80, 80},
+  {"neglectful", 12 * 3600UL, false, false, 50, 50},
+};
+static const uint8_t owner_count = sizeof(owners) / sizeof(owners[0]);
+
+static const uint32_t sim_start = 946713600UL;  // 2000-01-01 08:00
+static const uint32_t sim_days = 14;
+static const uint32_t bedtime = 15 * 3600UL;    // 23:00, counted from 08:00
+static const uint16_t hours_max = sim_days * 24;
+
+/**
+ * Tally
+ * Everything counted for one owner. Level ups by the hour they happened in, stats as histograms.
+ */
+struct tally {
+  uint64_t lifetimes;
+  uint64_t reached[level_max + 1];
+  uint64_t reached_at[level_max + 1][hours_max + 1];
+  uint64_t visits;
+  uint64_t sick;
+  uint64_t soiled;
+  uint64_t misbehaving;
+  uint64_t hunger[stat_max + 1];
+  uint64_t happy[stat_max + 1];
+  uint64_t discipline[stat_max + 1];
+};
+
+static void add(tally& into, const tally& from) {
+  const uint64_t *src = (const uint64_t *)&from;
+  uint64_t *dst = (uint64_t *)&into;
+  for (size_t i = 0; i < sizeof(tally) / sizeof(uint64_t); i++) {
+    dst[i] += src[i];
+  }
+}
+
+/**
+ * Lifetime Seed
+ * Mixes the base seed, owner and lifetime so neighbouring lifetimes don't start out correlated
+ */
+static unsigned long lifetime_seed(unsigned long seed, uint8_t who, unsigned long i) {
+  uint32_t x = (uint32_t)seed ^ ((uint32_t)who << 24) ^ (uint32_t)(i * 2654435761UL);
+  x ^= x >> 16;
+  x *= 0x85EBCA6BUL;
+  x ^= x >> 13;
+  x *= 0xC2B2AE35UL;
+  x ^= x >> 16;
+  return x;
+}
+
+/**
+ * Check In
+ * One visit: catch up, look, care, level up
+ */
+static void check_in(tamagotchi& tama, const owner& o, uint32_t t, uint32_t visit, tally& out) {
+  catchUp(tama, t);
+
+  out.visits++;
+  out.sick += !tama.health;
+  out.soiled += tama.soiled;
+  out.misbehaving += tama.misbehave;
+  out.hunger[tama.hunger]++;
+  out.happy[tama.happy]++;
+  out.discipline[tama.discipline]++;
+
+  if (!tama.health) {
+    care_heal(tama);
+  }
+  if (tama.soiled) {
+    care_clean(tama);
+  }
+  if (tama.misbehave) {
+    care_scold(tama);
+  }
+  if (tama.hunger < o.feed_below) {
+    o.snacks ? care_snack(tama) : care_meal(tama);
+  }
+  if (tama.happy < o.play_below) {
+    (visit & 1) ? care_right_left(tama) : care_over_under(tama);
+  }
+
+  if (level_up_due(tama, t)) {
+    care_level_up(tama, t);
+    out.reached[tama.level]++;
+    out.reached_at[tama.level][(t - sim_start) / 3600]++;
+  }
+}
+
+static void lifetime(const owner& o, tally& out) {
+  tamagotchi tama;
+  tama.birth = sim_start;
+  tama.ticked = sim_start;
+
+  const uint32_t end = sim_start + sim_days * 86400UL;
+  uint32_t t = sim_start;
+  uint32_t visit = 0;
+  while (t < end) {
+    check_in(tama, o, t, visit++, out);
+
+    uint32_t today = t - (t - sim_start) % 86400UL;
+    if (t + o.every < today + bedtime) {
+      t += o.every;
+      continue;
+    }
+    if (o.tucks_in) {
+      catchUp(tama, today + bedtime);
+      night_over(tama, night_morning(tama));
+    }
+    t = today + 86400UL;
+  }
+  out.lifetimes++;
+}
+
+static void worker(uint8_t who, unsigned long first, unsigned long lifetimes, unsigned step, unsigned long seed, tally *out) {
+  for (unsigned long i = first; i < lifetimes; i += step) {
+    rng_seed(lifetime_seed(seed, who, i));
+    lifetime(owners[who], *out);
+  }
+}
+
+/**
+ * Percentile
+ * Smallest bin at or below which the given share of the counts fall
+ */
+static unsigned percentile(const uint64_t *bins, unsigned count, double share) {
+  uint64_t total = 0;
+  for (unsigned i = 0; i < count; i++) {
+    total += bins[i];
+  }
+  uint64_t seen = 0;
+  for (unsigned i = 0; i < count; i++) {
+    seen += bins[i];
+    if (total > 0 && seen >= share * total) {
+      return i;
+    }
+  }
+  return count - 1;
+}
+
+static double percent(uint64_t part, uint64_t whole) {
+  return whole ? 100.0 * part / whole : 0.0;
+}
+
+static void report(const owner& o, const tally& t) {
+  printf("%-11s", o.name);
+  for (uint8_t level = 2; level <= level_max; level++) {
+    if (t.reached[level] > 0) {
+      printf("  L%u %5.1f%% %4uh", level, percent(t.reached[level], t.lifetimes),
+             percentile(t.reached_at[level], hours_max + 1, 0.5));
+    } else {
+      printf("  L%u %5.1f%%    - ", level, 0.0);
+    }
+  }
+  printf("  %5.1f%% %5.1f%% %5.1f%%", percent(t.sick, t.visits), percent(t.soiled, t.visits),
+         percent(t.misbehaving, t.visits));
+
+  const uint64_t *stats[3] = {t.hunger, t.happy, t.discipline};
+  for (uint8_t s = 0; s < 3; s++) {
+    printf("  %3u/%3u/%3u", percentile(stats[s], stat_max + 1, 0.1), percentile(stats[s], stat_max + 1, 0.5),
+           percentile(stats[s], stat_max + 1, 0.9));
+  }
+  printf("\n");
+}
+
+int sim_run(unsigned long lifetimes, unsigned threads, unsigned long seed) {
+  if (threads == 0) {
+    threads = std::thread::hardware_concurrency();
+    if (threads == 0) {
+      threads = 1;
+    }
+  }
+
+  printf("%lu lifetimes of %u days per owner, %u threads, seed %lu\n", lifetimes, sim_days, threads, seed);
+  printf("level: share of lifetimes that reached it, median hours to get there\n");
+  printf("at check-in: sick, soiled, misbehaving; hunger, happy and discipline as p10/p50/p90\n\n");
+  printf("%-11s  %-15s  %-15s  %-15s  %6s %6s %6s  %-11s  %-11s  %-11s\n", "owner", "level 2", "level 3",
+         "level 4", "sick", "soiled", "misbh", "hunger", "happy", "discipline");
+
+  auto start = std::chrono::steady_clock::now();
+  std::vector<tally> tallies(threads);
+  for (uint8_t who = 0; who < owner_count; who++) {
+    std::fill(tallies.begin(), tallies.end(), tally());
+    std::vector<std::thread> pool;
+    for (unsigned k = 0; k < threads; k++) {
+      pool.push_back(std::thread(worker, who, k, lifetimes, threads, seed, &tallies[k]));
+    }
+    for (std::thread& thread : pool) {
+      thread.join();
+    }
+
+    tally total = tally();
+    for (const tally& part : tallies) {
+      add(total, part);
+    }
+    report(owners[who], total);
+  }
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  printf("\n%.2f s, %.2f us per lifetime\n", seconds, seconds * 1e6 / ((double)lifetimes * owner_count));
+  return 0;
+}
+
+#endif
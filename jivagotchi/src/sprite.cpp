@@ -0,0 +1,75 @@
+/*
+ * Jiva-gotchi: Sprite Engine
+*/
+
+#include "sprite.h"
+#include "display.h"
+#include "assets.h"
+
+/**
+ * Decompress
+ * Expands an atlas bitmap's RLE stream (format in tools/gen_assets.py), stopping after len bytes
+ */
+static void sprite_unpack(uint8_t bitmap, unsigned char *out, uint8_t len) {
+  const uint8_t *src = asset_bitmap_data + pgm_read_word(&asset_bitmap_offset[bitmap]);
+  uint8_t written = 0;
+  while (written < len) {
+    uint8_t control = pgm_read_byte(src++);
+    uint8_t count = (control & 0x7F) + 1;
+    if (count > len - written) {
+      count = len - written;
+    }
+    if (control & 0x80) {
+      memset(out + written, pgm_read_byte(src++), count);
+    } else {
+      memcpy_P(out + written, src, count);
+      src += (control & 0x7F) + 1;
+    }
+    written += count;
+  }
+}
+
+/**
+ * Frame Lookup
+ * Copies a frame entry out of flash
+ *
+ * @return  False if level or frame is out of range
+ */
+static bool sprite_lookup(uint8_t level, uint8_t frame, sprite_frame& entry) {
+  if (level < 1 || level > asset_levels || frame >= idle_frames) {
+    return false;
+  }
+  memcpy_P(&entry, &asset_idle_frames[level - 1][frame], sizeof(entry));
+  return true;
+}
+
+bool sprite_compose(uint8_t level, uint8_t frame, unsigned char *out) {
+  sprite_frame entry;
+  if (!sprite_lookup(level, frame, entry)) {
+    return false;
+  }
+
+  const uint8_t row_bytes = sprite_width / 8;
+  memset(out, 0, entry.dy * row_bytes);
+  sprite_unpack(entry.bitmap, out + entry.dy * row_bytes, sprite_bytes - entry.dy * row_bytes);
+  if (entry.patch_row != no_patch) {
+    out[entry.patch_row * row_bytes] ^= entry.patch & 0xFF;
+    out[entry.patch_row * row_bytes + 1] ^= entry.patch >> 8;
+  }
+  return true;
+}
+
+uint8_t sprite_frame_ms(uint8_t level, uint8_t frame) {
+  sprite_frame entry;
+  if (!sprite_lookup(level, frame, entry)) {
+    return 0;
+  }
+  return entry.ms;
+}
+
+void draw_sprite(int posx, int posy, uint8_t level, uint8_t frame) {
+  unsigned char bits[sprite_bytes];
+  if (sprite_compose(level, frame, bits)) {
+    draw_bitmap_ram(posx, posy, sprite_width, sprite_height, bits);
+  }
+}
@@ -0,0 +1,103 @@
+/*
+ * Jiva-gotchi: Telemetry
+*/
+
+#include "telemetry.h"
+#include "pets.h"
+
+#ifdef ARDUINO
+#include <util/crc16.h>
+#endif
+
+static const uint8_t frame_overhead = 4;
+static const uint8_t state_size = 24;
+
+static uint16_t dropped = 0;
+
+/**
+ * Put
+ * Appends a little-endian value to a payload
+ *
+ * @param   out     Where the value goes, moved past it
+ * @param   value   The value
+ * @param   bytes   How many bytes of it
+ */
+static void put(uint8_t *&out, uint32_t value, uint8_t bytes) {
+  while (bytes-- > 0) {
+    *out++ = value & 0xFF;
+    value >>= 8;
+  }
+}
+
+/**
+ * Send
+ * Frames a payload and hands it to the TX ring whole, or drops it
+ *
+ * @param   type        The record type
+ * @param   payload     The payload
+ * @param   len         Payload length
+ */
+static void send(uint8_t type, const uint8_t *payload, uint8_t len) {
+  if (hal_serial_free() < len + frame_overhead) {
+    dropped++;
+    return;
+  }
+
+  uint8_t head[3] = {telemetry_sync, type, len};
+  uint8_t crc = 0;
+  crc = _crc8_ccitt_update(crc, type);
+  crc = _crc8_ccitt_update(crc, len);
+  for (uint8_t i = 0; i < len; i++) {
+    crc = _crc8_ccitt_update(crc, payload[i]);
+  }
+  hal_serial_write(head, sizeof(head));
+  hal_serial_write(payload, len);
+  hal_serial_write(&crc, 1);
+}
+
+void telemetry_state(const tamagotchi& tama) {
+  uint8_t payload[state_size];
+  uint8_t *out = payload;
+  put(out, hal_millis(), 4);
+  put(out, now, 4);
+  put(out, tama.birth, 4);
+  put(out, tama.ticked, 4);
+  put(out, tama.hunger, 1);
+  put(out, tama.happy, 1);
+  put(out, tama.discipline, 1);
+  put(out, tama.level, 1);
+  put(out, tama.snacks_fed, 1);
+  put(out, tama.health | (tama.soiled << 1) | (tama.misbehave << 2) | (active_pet << 5), 1);
+  put(out, dropped, 2);
+  send(record_state, payload, sizeof(payload));
+}
+
+void telemetry_event(uint8_t code, uint16_t arg) {
+  uint8_t payload[7];
+  uint8_t *out = payload;
+  put(out, hal_millis(), 4);
+  put(out, code, 1);
+  put(out, arg, 2);
+  send(record_event, payload, sizeof(payload));
+}
+
+void telemetry_sleep(const sleep_report& report) {
+  uint8_t payload[8];
+  uint8_t *out = payload;
+  put(out, hal_millis(), 4);
+  put(out, report.wakes, 2);
+  put(out, report.i2c, 2);
+  send(record_sleep, payload, sizeof(payload));
+}
+
+void telemetry_seed(uint32_t seed) {
+  uint8_t payload[8];
+  uint8_t *out = payload;
+  put(out, hal_millis(), 4);
+  put(out, seed, 4);
+  send(record_seed, payload, sizeof(payload));
+}
+
+uint16_t telemetry_dropped() {
+  return dropped;
+}
@@ -0,0 +1,380 @@
+/*
+ * Jiva-gotchi: I2C Transfer Engine
+ * One transaction is on the bus at a time, described by the fields below: the bytes at head, then the
+ * ones at body, then in_len bytes read after a repeated start. When it ends the interrupt picks the next
+ * one: a register access first (someone is waiting on it), then messages, then panel runs, and sends the
+ * STOP and the next START together.
+ *
+ * The queues have one writer (the functions at the bottom) and one reader (the interrupt). The writers
+ * fill a slot, then publish it with interrupts off, which also keeps the compiler from reordering the two.
+*/
+
+#if defined(ARDUINO) && JIV_TWI_ASYNC
+
+#include "twi.h"
+#include <util/twi.h>
+
+static uint8_t bitrate(uint32_t hz) {
+  return (F_CPU / hz - 16) / 2;
+}
+
+static const uint8_t twcr_run = bit(TWINT) | bit(TWEN) | bit(TWIE);
+
+/**
+ * Panel queue
+ */
+struct panel_run {
+  const uint8_t *data;
+  uint8_t page;
+  uint8_t column;
+  uint8_t len;
+};
+
+static const uint8_t panel_queue_size = 8;
+static panel_run panel_queue[panel_queue_size];
+static volatile uint8_t panel_head = 0;
+static volatile uint8_t panel_tail = 0;
+static uint8_t panel_address;
+static uint8_t panel_commands[7];
+
+/**
+ * Message slots
+ * Two with a page buffer, so one fills while the other is sent; the full frame buffer leaves no room
+ * for that, and only the init sequence and power save go through them there.
+ */
+struct message {
+  uint8_t address;
+  uint8_t len;
+  uint8_t data[twi_message_max];
+};
+
+#ifdef JIV_PAGE_BUFFER
+static const uint8_t message_slots = 2;
+#else
+static const uint8_t message_slots = 1;
+#endif
+static message messages[message_slots];
+static volatile uint8_t message_head = 0;
+static volatile uint8_t message_tail = 0;
+static volatile uint8_t message_count = 0;
+
+/**
+ * Register access request
+ * A register read or write, whoever asked waits for it
+ */
+enum request_state {
+  request_pending,
+  request_ok,
+  request_failed
+};
+
+static volatile bool request_wanted = false;
+static volatile uint8_t request_result = request_ok;
+static uint8_t request_address;
+static uint8_t request_reg;
+static const uint8_t *request_from;
+static uint8_t request_out;
+static uint8_t *request_to;
+static uint8_t request_in;
+static uint8_t request_bitrate;
+
+/**
+ * Transaction on the bus
+ */
+enum transfer_source {
+  source_none,
+  source_request,
+  source_message,
+  source_panel
+};
+
+static uint8_t source = source_none;
+static uint8_t address;
+static const uint8_t *head;
+static uint8_t head_len;
+static const uint8_t *body;
+static uint8_t body_len;
+static uint8_t *in;
+static uint8_t in_len;
+static uint8_t sent;
+static uint8_t received;
+static bool receiving;
+static volatile bool active = false;
+
+/**
+ * Next Transfer
+ * Sets up the next transaction, interrupts off
+ *
+ * @return  False if there is nothing to send
+ */
+static bool next_transfer() {
+  sent = 0;
+  received = 0;
+  receiving = false;
+  body_len = 0;
+  in_len = 0;
+
+  if (request_wanted) {
+    request_wanted = false;
+    source = source_request;
+    address = request_address;
+    head = &request_reg;
+    head_len = 1;
+    body = request_from;
+    body_len = request_out;
+    in = request_to;
+    in_len = request_in;
+    TWBR = request_bitrate;
+    return true;
+  }
+
+  TWBR = bitrate(twi_fast_hz);
+  if (message_count > 0) {
+    const message& m = messages[message_tail];
+    source = source_message;
+    address = m.address;
+    head = m.data;
+    head_len = m.len;
+    return true;
+  }
+
+  if (panel_tail != panel_head) {
+    const panel_run& run = panel_queue[panel_tail];
+    // Co set: a control byte follows each command; the last control byte makes the rest display data
+    panel_commands[0] = 0x80;
+    panel_commands[1] = 0x10 | (run.column >> 4);
+    panel_commands[2] = 0x80;
+    panel_commands[3] = run.column & 0x0F;
+    panel_commands[4] = 0x80;
+    panel_commands[5] = 0xB0 | run.page;
+    panel_commands[6] = 0x40;
+    source = source_panel;
+    address = panel_address;
+    head = panel_commands;
+    head_len = sizeof(panel_commands);
+    body = run.data;
+    body_len = run.len;
+    return true;
+  }
+
+  source = source_none;
+  return false;
+}
+
+/**
+ * Finish
+ * Frees what the transaction came from and moves on to the next one
+ */
+static void finish(bool ok) {
+  switch (source) {
+    case source_request:
+      request_result = ok ? request_ok : request_failed;
+      break;
+    case source_message:
+      message_tail = (message_tail + 1) % message_slots;
+      message_count--;
+      break;
+    case source_panel:
+      panel_tail = (panel_tail + 1) % panel_queue_size;
+      break;
+  }
+
+  if (next_transfer()) {
+    TWCR = twcr_run | bit(TWSTO) | bit(TWSTA);
+  } else {
+    TWCR = bit(TWINT) | bit(TWEN) | bit(TWSTO);
+    // A few microseconds; a START written before the STOP is out would be lost
+    while (TWCR & bit(TWSTO)) {
+    }
+    active = false;
+  }
+}
+
+/**
+ * Kick
+ * Starts the bus if it's idle, interrupts off
+ */
+static void kick() {
+  if (!active && next_transfer()) {
+    active = true;
+    TWCR = twcr_run | bit(TWSTA);
+  }
+}
+
+ISR (TWI_vect) {
+  switch (TW_STATUS) {
+    case TW_START:
+    case TW_REP_START:
+      TWDR = (address << 1) | (receiving ? TW_READ : TW_WRITE);
+      TWCR = twcr_run;
+      break;
+
+    case TW_MT_SLA_ACK:
+    case TW_MT_DATA_ACK:
+      if (sent < head_len) {
+        TWDR = head[sent++];
+        TWCR = twcr_run;
+      } else if (sent - head_len < body_len) {
+        TWDR = body[sent++ - head_len];
+        TWCR = twcr_run;
+      } else if (in_len > 0) {
+        receiving = true;
+        TWCR = twcr_run | bit(TWSTA);
+      } else {
+        finish(true);
+      }
+      break;
+
+    case TW_MR_SLA_ACK:
+      // ACK every byte but the last
+      TWCR = (in_len > 1) ? twcr_run | bit(TWEA) : twcr_run;
+      break;
+
+    case TW_MR_DATA_ACK:
+      in[received++] = TWDR;
+      TWCR = (received < in_len - 1) ? twcr_run | bit(TWEA) : twcr_run;
+      break;
+
+    case TW_MR_DATA_NACK:
+      in[received++] = TWDR;
+      finish(true);
+      break;
+
+    default:
+      // Nobody answered, or a bus error: drop the transaction, the next one starts afresh
+      finish(false);
+      break;
+  }
+}
+
+/**
+ * Reset
+ * Takes the TWI down and back up, dropping whatever was queued
+ */
+static void reset() {
+  noInterrupts();
+  TWCR = 0;
+  active = false;
+  source = source_none;
+  panel_tail = panel_head;
+  message_tail = message_head;
+  message_count = 0;
+  if (request_wanted || request_result == request_pending) {
+    request_wanted = false;
+    request_result = request_failed;
+  }
+  TWCR = bit(TWEN);
+  interrupts();
+}
+
+/**
+ * Stalled
+ * A device holding the bus would leave every wait below spinning, so after twi_timeout_ms the TWI is reset
+ *
+ * @param   since   millis() when the wait began
+ */
+static bool stalled(uint32_t since) {
+  if (millis() - since < twi_timeout_ms) {
+    return false;
+  }
+  reset();
+  return true;
+}
+
+void twi_begin() {
+  // The internal pull-ups, like Wire
+  digitalWrite(SDA, HIGH);
+  digitalWrite(SCL, HIGH);
+  TWSR = 0;
+  TWBR = bitrate(twi_fast_hz);
+  TWCR = bit(TWEN);
+}
+
+void twi_panel_write(uint8_t address, uint8_t page, uint8_t column, const uint8_t *data, uint8_t len) {
+  uint8_t next = (panel_head + 1) % panel_queue_size;
+  uint32_t since = millis();
+  while (next == panel_tail && !stalled(since)) {
+  }
+
+  panel_run& run = panel_queue[panel_head];
+  run.data = data;
+  run.page = page;
+  run.column = column;
+  run.len = len;
+
+  noInterrupts();
+  panel_address = address;
+  panel_head = next;
+  kick();
+  interrupts();
+}
+
+void twi_panel_wait() {
+  uint32_t since = millis();
+  while (panel_tail != panel_head && !stalled(since)) {
+  }
+}
+
+void twi_message_begin(uint8_t address) {
+  twi_panel_wait();
+  uint32_t since = millis();
+  while (message_count == message_slots && !stalled(since)) {
+  }
+  messages[message_head].address = address;
+  messages[message_head].len = 0;
+}
+
+void twi_message_add(const uint8_t *data, uint8_t len) {
+  message& m = messages[message_head];
+  while (len-- > 0 && m.len < twi_message_max) {
+    m.data[m.len++] = *data++;
+  }
+}
+
+void twi_message_end() {
+  noInterrupts();
+  message_head = (message_head + 1) % message_slots;
+  message_count++;
+  kick();
+  interrupts();
+}
+
+/**
+ * Request
+ * Hands a register access to the interrupt and waits for it
+ */
+static bool request(uint8_t address, uint8_t reg, const uint8_t *out, uint8_t out_len, uint8_t *in, uint8_t in_len, uint32_t hz) {
+  noInterrupts();
+  request_address = address;
+  request_reg = reg;
+  request_from = out;
+  request_out = out_len;
+  request_to = in;
+  request_in = in_len;
+  request_bitrate = bitrate(hz);
+  request_result = request_pending;
+  request_wanted = true;
+  kick();
+  interrupts();
+
+  uint32_t since = millis();
+  while (request_result == request_pending && !stalled(since)) {
+  }
+  return request_result == request_ok;
+}
+
+bool twi_read(uint8_t address, uint8_t reg, uint8_t *data, uint8_t len, uint32_t hz) {
+  return request(address, reg, NULL, 0, data, len, hz);
+}
+
+bool twi_write(uint8_t address, uint8_t reg, const uint8_t *data, uint8_t len, uint32_t hz) {
+  return request(address, reg, data, len, NULL, 0, hz);
+}
+
+void twi_wait() {
+  uint32_t since = millis();
+  while (active && !stalled(since)) {
+  }
+}
+
+#endif
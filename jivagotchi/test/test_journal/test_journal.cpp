@@ -0,0 +1,170 @@
+/*
+ * Jiva-gotchi: Save Journal Tests
+ * Recovery rules of include/journal.h against the native HAL's EEPROM. Run with: pio test -e native
+*/
+
+#include <unity.h>
+#include <string.h>
+#include "journal.h"
+
+static const int base = 0;
+static const uint8_t slots = 4;
+static const uint8_t len = 8;
+
+/**
+ * Record
+ * A payload that is different for every n
+ */
+struct record {
+  uint8_t bytes[len];
+
+  record(uint8_t n) {
+    memset(bytes, n, sizeof(bytes));
+  }
+};
+
+static int slot_address(uint8_t slot) {
+  return base + slot * journal_slot_size;
+}
+
+static void erase() {
+  uint8_t blank[journal_slot_size];
+  memset(blank, 0xFF, sizeof(blank));
+  for (uint8_t slot = 0; slot < slots; slot++) {
+    hal_storage_write(slot_address(slot), blank, sizeof(blank));
+  }
+}
+
+static journal reopen() {
+  journal j;
+  journal_open(j, base, slots, len);
+  return j;
+}
+
+static void assert_reads(const journal& j, uint8_t n) {
+  record expected(n), actual(0);
+  TEST_ASSERT_TRUE(journal_read(j, actual.bytes, len));
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(expected.bytes, actual.bytes, len);
+}
+
+void setUp() {
+  erase();
+}
+
+void tearDown() {
+}
+
+void test_empty_journal_has_no_record() {
+  journal j = reopen();
+  record r(0);
+  TEST_ASSERT_FALSE(j.valid);
+  TEST_ASSERT_FALSE(journal_read(j, r.bytes, len));
+}
+
+void test_newest_slot_wins() {
+  journal j = reopen();
+  // Six records in four slots: the newest is in slot 1, with older ones on either side of it
+  for (uint8_t n = 1; n <= 6; n++) {
+    journal_write(j, record(n).bytes, len);
+  }
+  j = reopen();
+  TEST_ASSERT_EQUAL_UINT8(1, j.newest);
+  TEST_ASSERT_EQUAL_UINT16(6, j.seq);
+  assert_reads(j, 6);
+}
+
+void test_same_payload_is_not_rewritten() {
+  journal j = reopen();
+  journal_write(j, record(1).bytes, len);
+  TEST_ASSERT_FALSE(journal_stage(j, record(1).bytes, len));
+  TEST_ASSERT_EQUAL_UINT16(1, reopen().seq);
+}
+
+void test_sequence_number_skips_erased_value() {
+  journal j = reopen();
+  // Start just short of the wrap, so the slots fill with 0xFFFC, 0xFFFD, 0xFFFE and then 0
+  j.seq = 0xFFFB;
+  for (uint8_t n = 1; n <= slots; n++) {
+    journal_write(j, record(n).bytes, len);
+  }
+  TEST_ASSERT_EQUAL_UINT16(0, j.seq);
+
+  // 0 comes after 0xFFFE, and still does with records on both sides of the wrap
+  j = reopen();
+  TEST_ASSERT_EQUAL_UINT16(0, j.seq);
+  TEST_ASSERT_EQUAL_UINT8(slots - 1, j.newest);
+  assert_reads(j, slots);
+  journal_write(j, record(5).bytes, len);
+  journal_write(j, record(6).bytes, len);
+  j = reopen();
+  TEST_ASSERT_EQUAL_UINT16(2, j.seq);
+  assert_reads(j, 6);
+}
+
+void test_torn_record_falls_back() {
+  // Cut off before each byte of the record in turn, the last being the sequence number
+  uint8_t total = journal_header_size + len;
+  for (uint8_t written = 0; written < total; written++) {
+    erase();
+    journal j = reopen();
+    journal_write(j, record(1).bytes, len);
+    journal_write(j, record(2).bytes, len);
+    TEST_ASSERT_TRUE(journal_stage(j, record(3).bytes, len));
+    TEST_ASSERT_FALSE(journal_step(j, written));
+    TEST_ASSERT_TRUE(journal_pending(j));
+    TEST_ASSERT_EQUAL_UINT16(3, journal_next_seq(j));
+
+    j = reopen();
+    TEST_ASSERT_EQUAL_UINT16(2, j.seq);
+    assert_reads(j, 2);
+  }
+}
+
+void test_torn_record_over_an_old_one_falls_back() {
+  journal j = reopen();
+  // Fill every slot, so the next record goes over a valid one (seq 1) and everything but its last byte lands
+  for (uint8_t n = 1; n <= slots; n++) {
+    journal_write(j, record(n).bytes, len);
+  }
+  TEST_ASSERT_TRUE(journal_stage(j, record(9).bytes, len));
+  TEST_ASSERT_FALSE(journal_step(j, journal_header_size + len - 1));
+
+  j = reopen();
+  TEST_ASSERT_EQUAL_UINT16(slots, j.seq);
+  assert_reads(j, slots);
+}
+
+void test_crc_mismatch_falls_back() {
+  journal j = reopen();
+  journal_write(j, record(1).bytes, len);
+  journal_write(j, record(2).bytes, len);
+
+  // Flip a payload byte of the newest record
+  uint8_t byte;
+  int address = slot_address(j.newest) + journal_header_size + len / 2;
+  hal_storage_get(address, byte);
+  byte ^= 0x10;
+  hal_storage_put(address, byte);
+
+  j = reopen();
+  TEST_ASSERT_EQUAL_UINT16(1, j.seq);
+  assert_reads(j, 1);
+
+  // The next record takes the slot after the one that checked out
+  journal_write(j, record(3).bytes, len);
+  j = reopen();
+  TEST_ASSERT_EQUAL_UINT16(2, j.seq);
+  assert_reads(j, 3);
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_empty_journal_has_no_record);
+  RUN_TEST(test_newest_slot_wins);
+  RUN_TEST(test_same_payload_is_not_rewritten);
+  RUN_TEST(test_sequence_number_skips_erased_value);
+  RUN_TEST(test_torn_record_falls_back);
+  RUN_TEST(test_torn_record_over_an_old_one_falls_back);
+  RUN_TEST(test_crc_mismatch_falls_back);
+  return UNITY_END();
+}
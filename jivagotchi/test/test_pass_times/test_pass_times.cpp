@@ -0,0 +1,156 @@
+/*
+ * Jiva-gotchi: Pass Times Tests
+ * passTimes(n) stands in for n calls to passTime() when catching up, so over many seeded trials the two
+ * have to end in the same outcomes at the same rates. Run with: pio test -e native
+*/
+
+#include <unity.h>
+#include "game.h"
+#include "rng.h"
+
+static const uint32_t trials = 20000;
+
+// Rates are off by about 0.005 at this many trials, means of the stats don't vary at all
+static const float rate_tolerance = 0.02f;
+static const float stat_tolerance = 0.5f;
+
+/**
+ * Outcomes
+ * How often trials ended soiled, sick or misbehaving, and the stats they ended with on average
+ */
+struct outcomes {
+  float soiled;
+  float sick;
+  float misbehave;
+  float happy;
+  float hunger;
+
+  outcomes() : soiled(0), sick(0), misbehave(0), happy(0), hunger(0) {
+  }
+
+  void add(const tamagotchi& tama) {
+    soiled += tama.soiled;
+    sick += !tama.health;
+    misbehave += tama.misbehave;
+    happy += tama.happy;
+    hunger += tama.hunger;
+  }
+
+  void average() {
+    soiled /= trials;
+    sick /= trials;
+    misbehave /= trials;
+    happy /= trials;
+    hunger /= trials;
+  }
+};
+
+static tamagotchi make(uint8_t happy, uint8_t hunger, uint8_t discipline, uint8_t snacks_fed, bool soiled) {
+  tamagotchi tama;
+  tama.happy = happy;
+  tama.hunger = hunger;
+  tama.discipline = discipline;
+  tama.snacks_fed = snacks_fed;
+  tama.soiled = soiled;
+  return tama;
+}
+
+/**
+ * Compare
+ * Runs the same tama through n passTime() calls and through passTimes(n), trials times each
+ */
+static void compare(const tamagotchi& start, uint32_t intervals) {
+  outcomes stepped, closed;
+
+  rng_seed(1);
+  for (uint32_t t = 0; t < trials; t++) {
+    tamagotchi tama = start;
+    for (uint32_t i = 0; i < intervals; i++) {
+      passTime(tama);
+    }
+    stepped.add(tama);
+  }
+  rng_seed(2);
+  for (uint32_t t = 0; t < trials; t++) {
+    tamagotchi tama = start;
+    passTimes(tama, intervals);
+    closed.add(tama);
+  }
+  stepped.average();
+  closed.average();
+
+  TEST_ASSERT_FLOAT_WITHIN_MESSAGE(rate_tolerance, stepped.soiled, closed.soiled, "soiled");
+  TEST_ASSERT_FLOAT_WITHIN_MESSAGE(rate_tolerance, stepped.sick, closed.sick, "sick");
+  TEST_ASSERT_FLOAT_WITHIN_MESSAGE(rate_tolerance, stepped.misbehave, closed.misbehave, "misbehave");
+  TEST_ASSERT_FLOAT_WITHIN_MESSAGE(stat_tolerance, stepped.happy, closed.happy, "happy");
+  TEST_ASSERT_FLOAT_WITHIN_MESSAGE(stat_tolerance, stepped.hunger, closed.hunger, "hunger");
+}
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+void test_no_intervals_changes_nothing() {
+  tamagotchi start = make(50, 50, 50, 0, false);
+  tamagotchi tama = start;
+  passTimes(tama, 0);
+  TEST_ASSERT_EQUAL_UINT8(start.happy, tama.happy);
+  TEST_ASSERT_EQUAL_UINT8(start.hunger, tama.hunger);
+  TEST_ASSERT_FALSE(tama.soiled);
+  TEST_ASSERT_TRUE(tama.health);
+  TEST_ASSERT_FALSE(tama.misbehave);
+}
+
+void test_clean_tama() {
+  compare(make(80, 80, 50, 0, false), 2);
+  compare(make(80, 80, 50, 0, false), 5);
+}
+
+void test_soiled_tama() {
+  compare(make(80, 80, 50, 0, true), 2);
+  compare(make(80, 80, 50, 0, true), 5);
+}
+
+void test_undisciplined_tama_misbehaves() {
+  compare(make(50, 50, 0, 0, false), 3);
+  compare(make(50, 50, 0, 0, true), 12);
+}
+
+void test_undisciplined_tama_at_zero_gets_sick() {
+  compare(make(0, 50, 0, 0, false), 4);
+  compare(make(50, 0, 0, 0, true), 4);
+}
+
+void test_too_many_snacks_sicken() {
+  compare(make(50, 50, 50, 6, false), 3);
+  compare(make(50, 50, 0, 6, false), 3);
+}
+
+void test_stat_reaching_zero() {
+  // happy hits 0 on the last interval: hungry and unhappy, but only the droppings can make it sick
+  compare(make(20, 60, 50, 0, false), 4);
+  // ...and one interval later it is sick, with the stats stopped at 0
+  compare(make(20, 60, 50, 0, false), 5);
+  // a stat that isn't a multiple of 5 still only lasts until it reaches 0
+  compare(make(60, 12, 50, 0, true), 6);
+}
+
+void test_long_absence() {
+  compare(make(100, 100, 50, 0, false), 48);
+  compare(make(100, 100, 0, 0, false), 48);
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_no_intervals_changes_nothing);
+  RUN_TEST(test_clean_tama);
+  RUN_TEST(test_soiled_tama);
+  RUN_TEST(test_undisciplined_tama_misbehaves);
+  RUN_TEST(test_undisciplined_tama_at_zero_gets_sick);
+  RUN_TEST(test_too_many_snacks_sicken);
+  RUN_TEST(test_stat_reaching_zero);
+  RUN_TEST(test_long_absence);
+  return UNITY_END();
+}
@@ -0,0 +1,85 @@
+/*
+ * Jiva-gotchi: Sleep Tests
+ * Runs the game loop on the native backend through the idle timeout: the glance screen comes up, the tama
+ * naps, and a press wakes it back to the home screen. Run with: pio test -e native
+*/
+
+#include <unity.h>
+#include "game.h"
+#include "power.h"
+
+void setup();
+void loop();
+
+static const uint32_t wake_ms = 400000UL;
+static uint32_t woken_at = 0;
+
+/**
+ * Script
+ * B at the boot prompt for a new tama, then nothing until A wakes it at wake_ms. A is only down for the
+ * one moment hal_sleep_wait() looks at it, so it doesn't open the menu once awake.
+ */
+static bool script(uint8_t pin, uint32_t ms) {
+  if (ms < 1000) {
+    return pin == buttonB;
+  }
+  if (pin != buttonA || ms < wake_ms) {
+    return false;
+  }
+  if (woken_at == 0) {
+    woken_at = ms;
+  }
+  return ms == woken_at;
+}
+
+static void run_until(uint32_t ms) {
+  while (hal_millis() < ms) {
+    loop();
+  }
+}
+
+/**
+ * Stats Lit
+ * How many pixels of the Happy/Hunger/Discipline lines are on
+ */
+static int stats_lit() {
+  int lit = 0;
+  for (int y = 28; y < 56; y++) {
+    for (int x = 0; x < 60; x++) {
+      lit += hal_native_pixel(x, y);
+    }
+  }
+  return lit;
+}
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+void test_glance_then_nap_then_wake_shows_stats() {
+  hal_native_set_input(script);
+  setup();
+
+  // The home screen, then only the glance screen once the idle time runs out
+  run_until(10000);
+  TEST_ASSERT_TRUE(stats_lit() > 0);
+  run_until((JIV_GLANCE_S + 5) * 1000UL);
+  TEST_ASSERT_EQUAL_UINT8(power_glance, power_stage());
+  TEST_ASSERT_EQUAL_INT(0, stats_lit());
+
+  // Naps at 300 s idle with the glance screen up, and wakes to the stats
+  run_until(wake_ms + 3000);
+  TEST_ASSERT_TRUE(woken_at > 0);
+  TEST_ASSERT_EQUAL_UINT32(1, last_sleep.wakes);
+  TEST_ASSERT_EQUAL_UINT8(power_full, power_stage());
+  TEST_ASSERT_FALSE(changed);
+  TEST_ASSERT_TRUE(stats_lit() > 0);
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_glance_then_nap_then_wake_shows_stats);
+  return UNITY_END();
+}
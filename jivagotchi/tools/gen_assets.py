@@ -0,0 +1,167 @@
+"""
+Jiva-gotchi: Asset Pipeline
+Turns the XBM files in art/Level N/ into include/assets.h.
+
+Frames that are the same picture moved down a few rows (optionally with one row touched up) are
+stored as a reference to an earlier bitmap instead of a copy, identical frames collapse into one
+atlas entry, and the bitmaps that remain are RLE-compressed. sprite.cpp decompresses on draw.
+
+Runs before every PlatformIO build (extra_scripts = pre:tools/gen_assets.py) and only rewrites the
+header when the art changed. Can also be run by hand: python tools/gen_assets.py
+"""
+
+import glob
+import os
+import re
+
+try:
+    Import("env")  # noqa: F821 - provided by PlatformIO/SCons
+    PROJECT_DIR = env.subst("$PROJECT_DIR")  # noqa: F821
+except NameError:
+    PROJECT_DIR = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+ART_DIR = os.path.join(PROJECT_DIR, "..", "art")
+OUTPUT = os.path.join(PROJECT_DIR, "include", "assets.h")
+
+WIDTH = 16
+HEIGHT = 24
+ROW_BYTES = WIDTH // 8
+MAX_DY = 7
+NO_PATCH = 0xFF
+
+# Time on screen for each idle frame, the last one lingers a little
+FRAME_MS = [34, 34, 34, 40]
+
+
+def read_xbm(path):
+    text = open(path).read()
+    width = int(re.search(r"_width\s+(\d+)", text).group(1))
+    height = int(re.search(r"_height\s+(\d+)", text).group(1))
+    if (width, height) != (WIDTH, HEIGHT):
+        raise ValueError("%s is %dx%d, sprites must be %dx%d" % (path, width, height, WIDTH, HEIGHT))
+    data = [int(b, 16) for b in re.findall(r"0x[0-9a-fA-F]{2}", text.split("{", 1)[1])]
+    return [data[r * ROW_BYTES] | data[r * ROW_BYTES + 1] << 8 for r in range(HEIGHT)]
+
+
+def derive(frame, base):
+    """(dy, patch_row, patch) that turns base into frame, or None"""
+    for dy in range(MAX_DY + 1):
+        moved = [0] * dy + base[:HEIGHT - dy]
+        diff = [r for r in range(HEIGHT) if moved[r] != frame[r]]
+        if not diff:
+            return (dy, NO_PATCH, 0)
+        if len(diff) == 1:
+            return (dy, diff[0], moved[diff[0]] ^ frame[diff[0]])
+    return None
+
+
+def rle(rows):
+    """
+    Byte RLE over the XBM bytes
+    Control byte 0x80 | (n - 1): the next byte repeated n times (n <= 128)
+    Control byte n - 1:          n literal bytes follow (n <= 128)
+    """
+    data = []
+    for row in rows:
+        data += [row & 0xFF, row >> 8]
+    out = []
+    i = 0
+    while i < len(data):
+        run = 1
+        while i + run < len(data) and data[i + run] == data[i] and run < 128:
+            run += 1
+        if run >= 3:
+            out += [0x80 | (run - 1), data[i]]
+            i += run
+            continue
+        start = i
+        while i < len(data) and i - start < 128:
+            if i + 2 < len(data) and data[i] == data[i + 1] == data[i + 2]:
+                break
+            i += 1
+        out += [i - start - 1] + data[start:i]
+    return out
+
+
+def build():
+    level_dirs = sorted(glob.glob(os.path.join(ART_DIR, "Level *")), key=lambda d: int(d.rsplit(" ", 1)[1]))
+    bitmaps = []
+    frames = []
+    for level_dir in level_dirs:
+        files = sorted(glob.glob(os.path.join(level_dir, "*.xbm")))
+        if len(files) != len(FRAME_MS):
+            raise ValueError("%s has %d frames, expected %d" % (level_dir, len(files), len(FRAME_MS)))
+        level = []
+        for index, path in enumerate(files):
+            rows = read_xbm(path)
+            entry = None
+            for bitmap_index, bitmap in enumerate(bitmaps):
+                match = derive(rows, bitmap)
+                if match is not None:
+                    entry = (bitmap_index,) + match
+                    break
+            if entry is None:
+                bitmaps.append(rows)
+                entry = (len(bitmaps) - 1, 0, NO_PATCH, 0)
+            level.append(entry + (FRAME_MS[index], os.path.relpath(path, ART_DIR)))
+        frames.append(level)
+    return bitmaps, frames
+
+
+def render(bitmaps, frames):
+    streams = [rle(b) for b in bitmaps]
+    offsets = []
+    data = []
+    for stream in streams:
+        offsets.append(len(data))
+        data += stream
+    raw = len(bitmaps) * HEIGHT * ROW_BYTES
+    total_frames = sum(len(level) for level in frames)
+
+    lines = [
+        "/*",
+        " * Jiva-gotchi: Generated Assets",
+        " * Generated by tools/gen_assets.py from art/, do not edit by hand",
+        " * %d frames -> %d bitmaps, %d bytes raw, %d bytes compressed" % (total_frames, len(bitmaps), raw, len(data)),
+        "*/",
+        "",
+        "#ifndef ASSETS_H",
+        "#define ASSETS_H",
+        "",
+        '#include "sprite.h"',
+        "",
+        "static const uint8_t asset_levels = %d;" % len(frames),
+        "",
+        "// RLE streams, see tools/gen_assets.py for the format",
+        "static const uint8_t asset_bitmap_data[] PROGMEM = {",
+    ]
+    for i in range(0, len(data), 12):
+        lines.append("  " + ", ".join("0x%02x" % b for b in data[i:i + 12]) + ",")
+    lines += [
+        "};",
+        "",
+        "static const uint16_t asset_bitmap_offset[] PROGMEM = { %s };" % ", ".join(str(o) for o in offsets),
+        "",
+        "// { bitmap, dy, patch_row, patch, ms }",
+        "static const sprite_frame asset_idle_frames[%d][idle_frames] PROGMEM = {" % len(frames),
+    ]
+    for level in frames:
+        lines.append("  {")
+        for bitmap, dy, patch_row, patch, ms, name in level:
+            patch_row = "no_patch" if patch_row == NO_PATCH else str(patch_row)
+            lines.append("    { %d, %d, %s, 0x%04x, %d }, // %s" % (bitmap, dy, patch_row, patch, ms, name))
+        lines.append("  },")
+    lines += ["};", "", "#endif", ""]
+    return "\n".join(lines)
+
+
+def main():
+    text = render(*build())
+    if os.path.exists(OUTPUT) and open(OUTPUT).read() == text:
+        return
+    with open(OUTPUT, "w") as f:
+        f.write(text)
+    print("gen_assets: wrote " + os.path.relpath(OUTPUT, PROJECT_DIR))
+
+
+main()
@@ -0,0 +1,196 @@
+"""
+Jiva-gotchi: Font Subsetter
+Cuts the u8g2 font the game draws with down to the glyphs it actually uses and writes
+include/font.h, which the Uno backend hands to u8g2.setFont().
+
+The glyphs are every character in the string and character literals of the sources built for the
+Uno, plus the digits for draw_number(). A u8g2 font is a 23 byte header followed by one record per glyph (encoding,
+record length, compressed bitmap) in encoding order, then a unicode lookup table. Each record decodes
+on its own, so a subset is the header, the kept records and the table, with the header's offsets to
+'A', 'a' and the table moved to match.
+
+Runs before every PlatformIO build (extra_scripts = pre:tools/gen_font.py), after the library
+dependencies are installed. Without the U8g2 sources (a native build, or by hand before the first Uno
+build) it writes a header that uses the whole font instead. Can also be run by hand:
+python tools/gen_font.py
+"""
+
+import glob
+import os
+import re
+
+try:
+    Import("env")  # noqa: F821 - provided by PlatformIO/SCons
+    PROJECT_DIR = env.subst("$PROJECT_DIR")  # noqa: F821
+    LIBDEPS_DIR = env.subst("$PROJECT_LIBDEPS_DIR")  # noqa: F821
+except NameError:
+    PROJECT_DIR = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+    LIBDEPS_DIR = os.path.join(PROJECT_DIR, ".pio", "libdeps")
+
+SOURCE_FONT = "u8g2_font_ncenB08_tr"
+OUTPUT = os.path.join(PROJECT_DIR, "include", "font.h")
+
+HEADER_SIZE = 23
+OFFSET_UPPER_A = 17
+OFFSET_LOWER_A = 19
+OFFSET_UNICODE = 21
+
+# Numbers are drawn from digits at run time, not from literals
+ALWAYS = "0123456789"
+
+STRING = re.compile(r'"((?:[^"\\\n]|\\.)*)"')
+CHAR = re.compile(r"'([^'\\\n]|\\.)'")
+ESCAPE = re.compile(r"\\([0-7]{1,3}|x[0-9a-fA-F]+|.)")
+SIMPLE_ESCAPES = {"n": 10, "t": 9, "r": 13, "a": 7, "b": 8, "f": 12, "v": 11, "0": 0}
+
+
+def unescape(literal):
+    """The bytes of a C string literal's contents."""
+    out = bytearray()
+    pos = 0
+    for m in ESCAPE.finditer(literal):
+        out += literal[pos:m.start()].encode("latin-1")
+        code = m.group(1)
+        if code[0] in "01234567":
+            out.append(int(code, 8) & 0xFF)
+        elif code[0] == "x":
+            out.append(int(code[1:], 16) & 0xFF)
+        else:
+            out.append(SIMPLE_ESCAPES.get(code, ord(code)))
+        pos = m.end()
+    out += literal[pos:].encode("latin-1")
+    return bytes(out)
+
+
+def uno_lines(text):
+    """The lines of a source file outside #ifndef ARDUINO blocks (or inside their #else)."""
+    stack = []  # for each open #if: whether it is host only
+    for line in text.splitlines():
+        directive = line.strip()
+        if directive.startswith("#if"):
+            stack.append(directive.split() == ["#ifndef", "ARDUINO"])
+            continue
+        if directive.startswith("#else") and stack:
+            stack[-1] = False
+            continue
+        if directive.startswith("#endif") and stack:
+            stack.pop()
+            continue
+        if directive.startswith("#include") or any(stack):
+            continue
+        yield line
+
+
+def used_glyphs():
+    """Every printable character in the string and character literals the Uno builds."""
+    chars = set(ALWAYS)
+    for path in sorted(glob.glob(os.path.join(PROJECT_DIR, "src", "*.cpp"))):
+        text = open(path, encoding="latin-1").read()
+        for line in uno_lines(text):
+            for m in list(STRING.finditer(line)) + list(CHAR.finditer(line)):
+                chars.update(chr(b) for b in unescape(m.group(1)) if 32 <= b < 127)
+    return "".join(sorted(chars))
+
+
+def find_font_source():
+    for path in sorted(glob.glob(os.path.join(LIBDEPS_DIR, "*", "U8g2", "src", "clib", "u8g2_fonts.c"))):
+        return path
+    return None
+
+
+def load_font(path, name):
+    text = open(path, encoding="latin-1").read()
+    m = re.search(re.escape(name) + r"\[\d+\][^=]*=\s*((?:\"(?:[^\"\\]|\\.)*\"\s*)+);", text)
+    if not m:
+        raise ValueError("%s not found in %s" % (name, path))
+    return b"".join(unescape(s) for s in STRING.findall(m.group(1)))
+
+
+def subset(font, keep):
+    header = bytearray(font[:HEADER_SIZE])
+    unicode_start = (font[OFFSET_UNICODE] << 8) | font[OFFSET_UNICODE + 1]
+
+    body = bytearray()
+    upper_a = lower_a = None
+    kept = []
+    pos = HEADER_SIZE
+    while font[pos + 1] != 0:
+        encoding, size = font[pos], font[pos + 1]
+        if chr(encoding) in keep:
+            if upper_a is None and encoding >= ord("A"):
+                upper_a = len(body)
+            if lower_a is None and encoding >= ord("a"):
+                lower_a = len(body)
+            body += font[pos:pos + size]
+            kept.append(chr(encoding))
+        pos += size
+
+    # The end marker and the unicode table keep their place relative to each other
+    removed = (pos - HEADER_SIZE) - len(body)
+    tail = font[pos:]
+    end = len(body)
+    body += tail
+
+    def put16(offset, value):
+        header[offset] = value >> 8
+        header[offset + 1] = value & 0xFF
+
+    header[0] = len(kept)
+    put16(OFFSET_UPPER_A, end if upper_a is None else upper_a)
+    put16(OFFSET_LOWER_A, end if lower_a is None else lower_a)
+    put16(OFFSET_UNICODE, unicode_start - removed)
+    return bytes(header + body), "".join(kept)
+
+
+def render(data, glyphs, full_size):
+    lines = [
+        "/*",
+        " * Jiva-gotchi: Generated Font",
+        " * Generated by tools/gen_font.py from %s, do not edit by hand" % SOURCE_FONT,
+        " * %d glyphs, %d of %d bytes: %s" % (len(glyphs), len(data), full_size, glyphs.replace("*/", "* /")),
+        "*/",
+        "",
+        "#ifndef FONT_H",
+        "#define FONT_H",
+        "",
+        "static const uint8_t game_font[] PROGMEM = {",
+    ]
+    for i in range(0, len(data), 12):
+        lines.append("  " + ", ".join("0x%02x" % b for b in data[i:i + 12]) + ",")
+    lines += ["};", "", "#endif", ""]
+    return "\n".join(lines)
+
+
+def render_fallback():
+    return "\n".join([
+        "/*",
+        " * Jiva-gotchi: Generated Font",
+        " * Generated by tools/gen_font.py without the U8g2 sources, so this is the whole of %s" % SOURCE_FONT,
+        "*/",
+        "",
+        "#ifndef FONT_H",
+        "#define FONT_H",
+        "",
+        "#define game_font %s" % SOURCE_FONT,
+        "",
+        "#endif",
+        "",
+    ])
+
+
+def main():
+    source = find_font_source()
+    if source is None:
+        text = render_fallback()
+    else:
+        font = load_font(source, SOURCE_FONT)
+        data, glyphs = subset(font, used_glyphs())
+        text = render(data, glyphs, len(font))
+    if os.path.exists(OUTPUT) and open(OUTPUT).read() == text:
+        return
+    with open(OUTPUT, "w") as f:
+        f.write(text)
+    print("gen_font: wrote " + os.path.relpath(OUTPUT, PROJECT_DIR))
+
+
+main()
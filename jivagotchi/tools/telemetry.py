@@ -0,0 +1,141 @@
+"""
+Jiva-gotchi: Telemetry Decoder
+Reads the binary telemetry frames described in include/telemetry.h and prints one line per record.
+
+Frames start with 0xA5, then type, payload length, payload and a CRC-8 (polynomial 0x07) over type,
+length and payload. Bytes that don't make a valid frame are skipped until the next 0xA5, so it's fine
+to start reading in the middle of a stream.
+
+Reads a serial port (needs pyserial) or a file written by the native build:
+    python tools/telemetry.py /dev/ttyACM0
+    python tools/telemetry.py telemetry.bin
+"""
+
+import os
+import struct
+import sys
+
+SYNC = 0xA5
+BAUD = 250000  # hal_serial_baud
+
+RECORD_STATE = 1
+RECORD_EVENT = 2
+RECORD_SLEEP = 3
+RECORD_SEED = 4
+
+EVENTS = {
+    1: "boot",
+    2: "no_rtc",
+    3: "action",
+    4: "level_up",
+    5: "sleep",
+    6: "wake",
+    7: "save",
+}
+
+# menu_entries in src/main.cpp, in order
+ACTIVITIES = ["Up/Down", "R/L", "Heal", "Scold", "Clean", "Feed", "Sleep", "Next pet"]
+
+SAVE_FIELDS = ["hunger", "happy", "discipline", "level", "health", "soiled", "misbehave",
+               "snacks_fed", "birth", "ticked"]
+
+
+def crc8(data):
+    crc = 0
+    for byte in data:
+        crc ^= byte
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x07) & 0xFF if crc & 0x80 else (crc << 1) & 0xFF
+    return crc
+
+
+def event_arg(code, arg):
+    if code == 1:
+        return ["new", "loaded", "resumed"][arg] if arg < 3 else str(arg)
+    if code == 3:
+        return ACTIVITIES[arg] if arg < len(ACTIVITIES) else str(arg)
+    if code == 5:
+        return "night" if arg else "nap"
+    if code == 6:
+        return "button" if arg else "timer"
+    if code == 7:
+        return ",".join(name for bit, name in enumerate(SAVE_FIELDS) if arg & (1 << bit))
+    return str(arg)
+
+
+def decode(kind, payload):
+    """Turns one payload into a line of text, or None if it isn't a record this tool knows."""
+    if kind == RECORD_STATE and len(payload) == 24:
+        (ms, now, birth, ticked, hunger, happy, discipline, level, snacks, flags,
+         dropped) = struct.unpack("<IIIIBBBBBBH", payload)
+        return ("%10d ms  state  pet=%d now=%d birth=%d ticked=%d hunger=%d happy=%d discipline=%d level=%d "
+                "snacks=%d health=%d soiled=%d misbehave=%d dropped=%d"
+                % (ms, flags >> 5, now, birth, ticked, hunger, happy, discipline, level, snacks,
+                   flags & 1, (flags >> 1) & 1, (flags >> 2) & 1, dropped))
+    if kind == RECORD_EVENT and len(payload) == 7:
+        ms, code, arg = struct.unpack("<IBH", payload)
+        name = EVENTS.get(code, "event%d" % code)
+        return "%10d ms  %-6s %s" % (ms, name, event_arg(code, arg))
+    if kind == RECORD_SLEEP and len(payload) == 8:
+        ms, wakes, i2c = struct.unpack("<IHH", payload)
+        return "%10d ms  slept  %d wakes, %d I2C transactions" % (ms, wakes, i2c)
+    if kind == RECORD_SEED and len(payload) == 8:
+        ms, seed = struct.unpack("<II", payload)
+        return "%10d ms  seed   %d (replay with -D JIV_RNG_SEED=%d)" % (ms, seed, seed)
+    return None
+
+
+def frames(read):
+    """Yields (type, payload) for every frame with a good CRC. read(n) returns up to n bytes, b"" at the end."""
+    buf = bytearray()
+    while True:
+        chunk = read(256)
+        if not chunk:
+            return
+        buf += chunk
+        while True:
+            start = buf.find(SYNC)
+            if start < 0:
+                del buf[:]
+                break
+            del buf[:start]
+            if len(buf) < 3 or len(buf) < 3 + buf[2] + 1:
+                break
+            end = 3 + buf[2]
+            if crc8(buf[1:end]) == buf[end]:
+                yield buf[1], bytes(buf[3:end])
+                del buf[:end + 1]
+            else:
+                # Not a frame after all, look for the next sync byte
+                del buf[:1]
+
+
+def main():
+    if len(sys.argv) != 2:
+        print("usage: telemetry.py <serial port | file>", file=sys.stderr)
+        return 2
+
+    source = sys.argv[1]
+    if os.path.isfile(source):
+        stream = open(source, "rb")
+        read = stream.read
+    else:
+        import serial  # pyserial, only needed for a live port
+        stream = serial.Serial(source, BAUD, timeout=None)
+
+        def read(n):
+            return stream.read(max(1, min(n, stream.in_waiting)))
+
+    with stream:
+        try:
+            for kind, payload in frames(read):
+                line = decode(kind, payload)
+                print(line if line is not None else "unknown record %d: %s" % (kind, payload.hex()))
+                sys.stdout.flush()
+        except KeyboardInterrupt:
+            pass
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())